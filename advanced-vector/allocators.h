@@ -0,0 +1,156 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Аллокатор поверх malloc/free. Умеет reallocate, поэтому Vector тривиально перемещаемых типов
+// растет через realloc: блок расширяется на месте, а крупные блоки, выделенные glibc через mmap,
+// переотображаются mremap без копирования содержимого
+template <typename T>
+struct MallocAllocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc does not provide required alignment");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    MallocAllocator() = default;
+
+    template <typename U>
+    MallocAllocator(const MallocAllocator<U>& /*other*/) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        void* p = std::malloc(n * sizeof(T));
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t /*n*/) noexcept {
+        std::free(p);
+    }
+
+    T* reallocate(T* p, size_t /*old_n*/, size_t new_n) noexcept {
+        if (new_n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            return nullptr;
+        }
+        return static_cast<T*>(std::realloc(static_cast<void*>(p), new_n * sizeof(T)));
+    }
+
+    template <typename U>
+    bool operator==(const MallocAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const MallocAllocator<U>& /*other*/) const noexcept {
+        return false;
+    }
+};
+
+// Аллокатор, выравнивающий каждый буфер по границе Alignment байт, например по кэш-линии или по
+// ширине регистров AVX-512. Vector узнает выравнивание из ALIGNMENT и сообщает его компилятору в begin()
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static constexpr size_t ALIGNMENT = Alignment > alignof(T) ? Alignment : alignof(T);
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>& /*other*/) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ALIGNMENT}));
+    }
+
+    void deallocate(T* p, size_t /*n*/) noexcept {
+        ::operator delete(p, std::align_val_t{ALIGNMENT});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>& /*other*/) const noexcept {
+        return false;
+    }
+};
+
+// Аллокатор для буферов, полученных от C-библиотек вместе с функцией освобождения: принятый
+// Vector::Adopt буфер освобождается вызовом deleter(context, p), а буферы, выделенные при росте
+// вектора, - через malloc/free. Копии аллокатора разделяют состояние, поэтому буфер освобождается
+// один раз, какая бы копия его ни освобождала
+template <typename T>
+class DeleterAllocator {
+    template <typename U>
+    friend class DeleterAllocator;
+
+public:
+    using value_type = T;
+    using Deleter = void (*)(void* context, void* p);
+
+    DeleterAllocator() = default;
+
+    DeleterAllocator(T* adopted, Deleter deleter, void* context = nullptr)
+        : state_(std::make_shared<State>(State{adopted, deleter, context})) {}
+
+    template <typename U>
+    DeleterAllocator(const DeleterAllocator<U>& other) noexcept
+        : state_(other.state_) {}
+
+    T* allocate(size_t n) {
+        return MallocAllocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (state_ != nullptr && state_->adopted == p) {
+            state_->adopted = nullptr;
+            state_->deleter(state_->context, p);
+        } else {
+            MallocAllocator<T>().deallocate(p, n);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const DeleterAllocator<U>& other) const noexcept {
+        return state_ == other.state_;
+    }
+
+    template <typename U>
+    bool operator!=(const DeleterAllocator<U>& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    struct State {
+        // Еще не освобожденный принятый буфер
+        void* adopted;
+        Deleter deleter;
+        void* context;
+    };
+
+    std::shared_ptr<State> state_;
+};
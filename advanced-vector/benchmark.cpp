@@ -0,0 +1,453 @@
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sorted_vector.h"
+#include "vector.h"
+#include "vector_algorithms.h"
+#include "vector_pool.h"
+
+// Сборка: g++ -std=c++17 -O2 -DNDEBUG benchmark.cpp -lbenchmark -lpthread
+// Vector и std::vector измеряются попарно на одних и тех же типах и размерах
+
+namespace {
+
+struct AllocationCounters {
+    static void Reset() {
+        num_allocations = 0;
+        num_bytes_allocated = 0;
+        num_bytes_copied = 0;
+    }
+
+    static inline int64_t num_allocations = 0;
+    static inline int64_t num_bytes_allocated = 0;
+    static inline int64_t num_bytes_copied = 0;
+};
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& /*other*/) noexcept {}
+
+    T* allocate(size_t n) {
+        ++AllocationCounters::num_allocations;
+        AllocationCounters::num_bytes_allocated += static_cast<int64_t>(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>& /*other*/) const noexcept {
+        return false;
+    }
+};
+
+struct Pod64 {
+    char data[64];
+};
+
+// Перемещение не помечено noexcept, поэтому контейнеры копируют такие элементы при реаллокации.
+// Копирования подсчитываются, а не бросают исключения
+struct ThrowingCopy {
+    ThrowingCopy() = default;
+
+    explicit ThrowingCopy(std::string value)
+        : payload(std::move(value)) {}
+
+    ThrowingCopy(const ThrowingCopy& other)
+        : payload(other.payload) {
+        AllocationCounters::num_bytes_copied += sizeof(ThrowingCopy);
+    }
+
+    ThrowingCopy(ThrowingCopy&& other)
+        : payload(std::move(other.payload)) {}
+
+    ThrowingCopy& operator=(const ThrowingCopy& other) {
+        payload = other.payload;
+        AllocationCounters::num_bytes_copied += sizeof(ThrowingCopy);
+        return *this;
+    }
+
+    ThrowingCopy& operator=(ThrowingCopy&& other) {
+        payload = std::move(other.payload);
+        return *this;
+    }
+
+    std::string payload;
+};
+
+// Длина строк в std::string и ThrowingCopy: больше буфера SSO, чтобы копирование обращалось к куче
+constexpr size_t PAYLOAD_SIZE = 32;
+
+template <typename T>
+T MakeValue(size_t i) {
+    if constexpr (std::is_same_v<T, int>) {
+        return static_cast<int>(i);
+    } else if constexpr (std::is_same_v<T, Pod64>) {
+        Pod64 pod;
+        std::fill(std::begin(pod.data), std::end(pod.data), static_cast<char>(i));
+        return pod;
+    } else {
+        return T(std::string(PAYLOAD_SIZE, static_cast<char>('a' + i % 26)));
+    }
+}
+
+template <typename T>
+int64_t Weight(const T& value) {
+    if constexpr (std::is_same_v<T, int>) {
+        return value;
+    } else if constexpr (std::is_same_v<T, Pod64>) {
+        return value.data[0];
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return static_cast<int64_t>(value.size());
+    } else {
+        return static_cast<int64_t>(value.payload.size());
+    }
+}
+
+// Единый интерфейс над Vector и std::vector
+template <typename T>
+void Append(Vector<T, CountingAllocator<T>>& v, const T& value) {
+    v.PushBack(value);
+}
+
+template <typename T>
+void Append(std::vector<T, CountingAllocator<T>>& v, const T& value) {
+    v.push_back(value);
+}
+
+template <typename T>
+void AppendTemporary(Vector<T, CountingAllocator<T>>& v, size_t i) {
+    v.EmplaceBack(MakeValue<T>(i));
+}
+
+template <typename T>
+void AppendTemporary(std::vector<T, CountingAllocator<T>>& v, size_t i) {
+    v.emplace_back(MakeValue<T>(i));
+}
+
+template <typename T>
+void Reserve(Vector<T, CountingAllocator<T>>& v, size_t capacity) {
+    v.Reserve(capacity);
+}
+
+template <typename T>
+void Reserve(std::vector<T, CountingAllocator<T>>& v, size_t capacity) {
+    v.reserve(capacity);
+}
+
+template <typename T>
+void InsertAndEraseMiddle(Vector<T, CountingAllocator<T>>& v, const T& value) {
+    v.Insert(v.begin() + v.Size() / 2, value);
+    v.Erase(v.begin() + v.Size() / 2);
+}
+
+template <typename T>
+void InsertAndEraseMiddle(std::vector<T, CountingAllocator<T>>& v, const T& value) {
+    v.insert(v.begin() + v.size() / 2, value);
+    v.erase(v.begin() + v.size() / 2);
+}
+
+template <typename Container>
+Container MakeContainer(size_t size) {
+    using T = typename Container::value_type;
+    Container v;
+    Reserve(v, size);
+    for (size_t i = 0; i < size; ++i) {
+        Append(v, MakeValue<T>(i));
+    }
+    return v;
+}
+
+void ReportCounters(benchmark::State& state, int64_t elements_per_iteration) {
+    using benchmark::Counter;
+    const auto iterations = static_cast<double>(state.iterations());
+    state.counters["ns/op"] = Counter(static_cast<double>(elements_per_iteration) * iterations,
+                                      Counter::kIsRate | Counter::kInvert, Counter::kIs1000);
+    state.counters["allocs"] = Counter(static_cast<double>(AllocationCounters::num_allocations), Counter::kAvgIterations);
+    state.counters["bytes_alloc"] = Counter(static_cast<double>(AllocationCounters::num_bytes_allocated),
+                                            Counter::kAvgIterations, Counter::kIs1024);
+    state.counters["bytes_copied"] = Counter(static_cast<double>(AllocationCounters::num_bytes_copied),
+                                             Counter::kAvgIterations, Counter::kIs1024);
+    state.SetItemsProcessed(elements_per_iteration * state.iterations());
+}
+
+template <typename Container>
+void BM_PushBack(benchmark::State& state) {
+    using T = typename Container::value_type;
+    const size_t size = state.range(0);
+    const T value = MakeValue<T>(1);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < size; ++i) {
+            Append(v, value);
+        }
+        benchmark::DoNotOptimize(&v);
+    }
+    ReportCounters(state, size);
+}
+
+template <typename Container>
+void BM_EmplaceBack(benchmark::State& state) {
+    const size_t size = state.range(0);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < size; ++i) {
+            AppendTemporary(v, i);
+        }
+        benchmark::DoNotOptimize(&v);
+    }
+    ReportCounters(state, size);
+}
+
+template <typename Container>
+void BM_ReserveThenPushBack(benchmark::State& state) {
+    using T = typename Container::value_type;
+    const size_t size = state.range(0);
+    const T value = MakeValue<T>(1);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        Container v;
+        Reserve(v, size);
+        for (size_t i = 0; i < size; ++i) {
+            Append(v, value);
+        }
+        benchmark::DoNotOptimize(&v);
+    }
+    ReportCounters(state, size);
+}
+
+template <typename Container>
+void BM_InsertEraseMiddle(benchmark::State& state) {
+    using T = typename Container::value_type;
+    const size_t size = state.range(0);
+    const T value = MakeValue<T>(1);
+    Container v = MakeContainer<Container>(size);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        InsertAndEraseMiddle(v, value);
+        benchmark::ClobberMemory();
+    }
+    ReportCounters(state, 1);
+}
+
+template <typename Container>
+void BM_CopyAssign(benchmark::State& state) {
+    const size_t size = state.range(0);
+    const Container src = MakeContainer<Container>(size);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        Container dst;
+        dst = src;
+        benchmark::DoNotOptimize(&dst);
+    }
+    ReportCounters(state, size);
+}
+
+template <typename Container>
+void BM_MoveAssign(benchmark::State& state) {
+    const size_t size = state.range(0);
+    Container src = MakeContainer<Container>(size);
+    Container dst;
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        dst = std::move(src);
+        src = std::move(dst);
+        benchmark::DoNotOptimize(&src);
+    }
+    ReportCounters(state, 1);
+}
+
+template <typename Container>
+void BM_Iterate(benchmark::State& state) {
+    const size_t size = state.range(0);
+    const Container v = MakeContainer<Container>(size);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (const auto& value : v) {
+            sum += Weight(value);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    ReportCounters(state, size);
+}
+
+// Склейка частичных результатов потоков: последовательный Append против ParallelAppend.
+// Счетчики выделений учитывают и подготовку частей
+template <bool Parallel>
+void BM_Concatenate(benchmark::State& state) {
+    using Part = Vector<int, CountingAllocator<int>>;
+    const size_t size = state.range(0);
+    const size_t num_parts = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    AllocationCounters::Reset();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Part> parts(num_parts);
+        for (Part& part : parts) {
+            part = MakeContainer<Part>(size / num_parts);
+        }
+        state.ResumeTiming();
+        Part result;
+        if constexpr (Parallel) {
+            result.ParallelAppend(parts.begin(), parts.end());
+        } else {
+            for (Part& part : parts) {
+                result.Append(part.begin(), part.end());
+            }
+        }
+        benchmark::DoNotOptimize(&result);
+    }
+    ReportCounters(state, size);
+}
+
+// Поиск отсутствующего значения и сумма: стандартные алгоритмы против векторных ядер Find и Sum
+template <bool Simd>
+void BM_FindAbsent(benchmark::State& state) {
+    const auto v = MakeContainer<Vector<int, CountingAllocator<int>>>(state.range(0));
+    for (auto _ : state) {
+        const int* found = Simd ? Find(v, -1) : std::find(v.begin(), v.end(), -1);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetBytesProcessed(state.iterations() * v.Size() * sizeof(int));
+}
+
+template <bool Simd>
+void BM_Sum(benchmark::State& state) {
+    const auto v = MakeContainer<Vector<int, CountingAllocator<int>>>(state.range(0));
+    for (auto _ : state) {
+        const int64_t sum = Simd ? Sum(v) : std::accumulate(v.begin(), v.end(), int64_t{0});
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * v.Size() * sizeof(int));
+}
+
+// Короткоживущие векторы, как в обработчиках запросов: std::allocator против пула потока
+template <typename Allocator>
+void BM_ShortLived(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        Vector<int, Allocator> v;
+        for (int i = 0; i < size; ++i) {
+            v.PushBack(i);
+        }
+        benchmark::DoNotOptimize(v.Data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Поиск всех ключей небольшой таблицы в случайном порядке: std::map против FlatMap
+template <typename Map>
+void BM_Lookup(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    Map map;
+    std::vector<int> keys(size);
+    for (int i = 0; i < size; ++i) {
+        map[i * 2] = i;
+        keys[i] = static_cast<int>((i * 7919LL) % size) * 2;
+    }
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (int key : keys) {
+            sum += map.find(key)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// FlatMap с именами методов std::map для BM_Lookup
+struct BenchFlatMap : FlatMap<int, int> {
+    auto find(int key) {
+        return Find(key);
+    }
+};
+
+// Память одного элемента вместе с буфером строки, которым он владеет. Буфер занимает строку с
+// завершающим нулем, округленную malloc вместе со служебными байтами
+template <typename T>
+constexpr size_t ElementFootprint() {
+    if constexpr (std::is_same_v<T, int> || std::is_same_v<T, Pod64>) {
+        return sizeof(T);
+    } else {
+        return sizeof(T) + (PAYLOAD_SIZE + 1 + sizeof(size_t) + 15) / 16 * 16;
+    }
+}
+
+// Размеры от 8 до 10^8, но не больше 512 МБ на все копии контейнера, которые бенчмарк держит
+// одновременно
+template <typename T, int LIVE_COPIES>
+void Sizes(benchmark::internal::Benchmark* b) {
+    const int64_t max_size = std::min<int64_t>(100'000'000,
+                                               (int64_t{512} << 20) / (ElementFootprint<T>() * LIVE_COPIES));
+    for (int64_t size = 8; size <= max_size; size *= 10) {
+        b->Arg(size);
+    }
+    b->Unit(benchmark::kMicrosecond);
+}
+
+template <typename T>
+using BenchVector = Vector<T, CountingAllocator<T>>;
+
+template <typename T>
+using BenchStdVector = std::vector<T, CountingAllocator<T>>;
+
+}  // namespace
+
+// LIVE_COPIES - сколько копий контейнера бенчмарк держит одновременно. При реаллокации старый
+// буфер живет вместе с новым, а ThrowingCopy при этом еще и копируется; первая вставка в
+// заполненный MakeContainer контейнер выделяет буфер вдвое больше старого
+#define VECTOR_BENCHMARK(Op, T, LIVE_COPIES)                                        \
+    BENCHMARK_TEMPLATE(Op, BenchStdVector<T>)->Apply(Sizes<T, LIVE_COPIES>);        \
+    BENCHMARK_TEMPLATE(Op, BenchVector<T>)->Apply(Sizes<T, LIVE_COPIES>)
+
+#define VECTOR_BENCHMARK_ALL_TYPES(Op, LIVE_COPIES)   \
+    VECTOR_BENCHMARK(Op, int, LIVE_COPIES);           \
+    VECTOR_BENCHMARK(Op, Pod64, LIVE_COPIES);         \
+    VECTOR_BENCHMARK(Op, std::string, LIVE_COPIES);   \
+    VECTOR_BENCHMARK(Op, ThrowingCopy, LIVE_COPIES)
+
+VECTOR_BENCHMARK_ALL_TYPES(BM_PushBack, 2);
+VECTOR_BENCHMARK_ALL_TYPES(BM_EmplaceBack, 2);
+VECTOR_BENCHMARK_ALL_TYPES(BM_ReserveThenPushBack, 1);
+VECTOR_BENCHMARK_ALL_TYPES(BM_InsertEraseMiddle, 3);
+VECTOR_BENCHMARK_ALL_TYPES(BM_CopyAssign, 2);
+VECTOR_BENCHMARK_ALL_TYPES(BM_MoveAssign, 1);
+VECTOR_BENCHMARK_ALL_TYPES(BM_Iterate, 1);
+
+BENCHMARK_TEMPLATE(BM_Concatenate, false)->Range(1 << 16, 1 << 26)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_Concatenate, true)->Range(1 << 16, 1 << 26)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_FindAbsent, false)->Range(1 << 10, 1 << 24);
+BENCHMARK_TEMPLATE(BM_FindAbsent, true)->Range(1 << 10, 1 << 24);
+BENCHMARK_TEMPLATE(BM_Sum, false)->Range(1 << 10, 1 << 24);
+BENCHMARK_TEMPLATE(BM_Sum, true)->Range(1 << 10, 1 << 24);
+
+BENCHMARK_TEMPLATE(BM_ShortLived, std::allocator<int>)->Range(16, 1 << 12);
+BENCHMARK_TEMPLATE(BM_ShortLived, PoolAllocator<int>)->Range(16, 1 << 12);
+
+BENCHMARK_TEMPLATE(BM_Lookup, std::map<int, int>)->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_Lookup, BenchFlatMap)->Range(16, 1 << 16);
+
+BENCHMARK_MAIN();
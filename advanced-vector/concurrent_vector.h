@@ -0,0 +1,169 @@
+
+#pragma once
+
+#include <atomic>
+
+#include "vector.h"
+
+// Вектор для одновременного добавления элементов из нескольких потоков. Элементы хранятся в сегментах,
+// размеры которых растут степенями двойки: сегмент k содержит FIRST_SEGMENT_SIZE * 2^k элементов.
+// Уже созданные элементы никогда не переносятся, поэтому ссылки на них остаются действительными.
+// Индекс элемента резервируется атомарным инкрементом, после чего элемент создается без блокировок
+// и публикуется флагом готовности: читатели видят только полностью созданные элементы
+template <typename T, typename Allocator = std::allocator<T>>
+class ConcurrentVector {
+    struct Slot {
+        Slot() noexcept {}
+
+        T* Get() noexcept {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::atomic<bool> ready{false};
+    };
+
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+
+public:
+    using value_type = T;
+
+    static constexpr size_t FIRST_SEGMENT_SIZE = 32;
+    static constexpr size_t MAX_SEGMENTS = 64 - 5;
+
+    ConcurrentVector() = default;
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        ForEachSlot([](Slot& slot) {
+            std::destroy_at(slot.Get());
+        });
+        for (size_t k = 0; k < MAX_SEGMENTS; ++k) {
+            std::destroy_n(segments_[k].GetAddress(), segments_[k].Capacity());
+        }
+    }
+
+    // Потокобезопасно. Возвращает индекс созданного элемента. Если конструктор элемента бросит
+    // исключение, индекс останется занятым, но элемент по нему никогда не будет опубликован
+    template <typename... Args>
+    size_t EmplaceBack(Args&&... args) {
+        const size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = EnsureSegment(SegmentOf(index))[OffsetInSegment(index)];
+        new (slot.Get()) T(std::forward<Args>(args)...);
+        slot.ready.store(true, std::memory_order_release);
+        return index;
+    }
+
+    template <typename S>
+    size_t PushBack(S&& value) {
+        return EmplaceBack(std::forward<S>(value));
+    }
+
+    // Потокобезопасно. Заранее выделяет сегменты для первых capacity элементов
+    void Reserve(size_t capacity) {
+        for (size_t k = 0; k < MAX_SEGMENTS && SegmentBegin(k) < capacity; ++k) {
+            EnsureSegment(k);
+        }
+    }
+
+    // Количество зарезервированных индексов, включая элементы, которые еще создаются
+    size_t Size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    bool IsPublished(size_t index) const noexcept {
+        return TryGet(index) != nullptr;
+    }
+
+    // Потокобезопасно. Возвращает nullptr, если элемент еще не опубликован
+    const T* TryGet(size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this).TryGet(index);
+    }
+
+    T* TryGet(size_t index) noexcept {
+        if (index >= Size()) return nullptr;
+        Slot* segment = published_[SegmentOf(index)].load(std::memory_order_acquire);
+        if (segment == nullptr) return nullptr;
+        Slot& slot = segment[OffsetInSegment(index)];
+        return slot.ready.load(std::memory_order_acquire) ? slot.Get() : nullptr;
+    }
+
+    // Элемент должен быть опубликован: например, индекс получен от EmplaceBack
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        T* value = TryGet(index);
+        assert(value != nullptr);
+        return *value;
+    }
+
+    // Обходит опубликованные элементы сегмент за сегментом
+    template <typename F>
+    void ForEach(F f) const {
+        const_cast<ConcurrentVector&>(*this).ForEachSlot([&f](Slot& slot) {
+            f(std::as_const(*slot.Get()));
+        });
+    }
+
+    static size_t SegmentOf(size_t index) noexcept {
+        size_t x = index / FIRST_SEGMENT_SIZE + 1;
+        size_t segment = 0;
+        while (x >>= 1) {
+            ++segment;
+        }
+        return segment;
+    }
+
+    static size_t SegmentBegin(size_t segment) noexcept {
+        return FIRST_SEGMENT_SIZE * ((size_t{1} << segment) - 1);
+    }
+
+    static size_t SegmentSize(size_t segment) noexcept {
+        return FIRST_SEGMENT_SIZE << segment;
+    }
+
+private:
+    RawMemory<Slot, SlotAllocator> segments_[MAX_SEGMENTS];
+    std::atomic<Slot*> published_[MAX_SEGMENTS] = {};
+    std::atomic<size_t> size_{0};
+
+    static size_t OffsetInSegment(size_t index) noexcept {
+        return index - SegmentBegin(SegmentOf(index));
+    }
+
+    template <typename F>
+    void ForEachSlot(F f) {
+        const size_t size = Size();
+        for (size_t k = 0; k < MAX_SEGMENTS && SegmentBegin(k) < size; ++k) {
+            Slot* segment = published_[k].load(std::memory_order_acquire);
+            if (segment == nullptr) continue;
+            const size_t count = std::min(SegmentSize(k), size - SegmentBegin(k));
+            for (size_t i = 0; i < count; ++i) {
+                if (segment[i].ready.load(std::memory_order_acquire)) {
+                    f(segment[i]);
+                }
+            }
+        }
+    }
+
+    // Сегмент выделяет любой поток, которому он понадобился первым; проигравшие в гонке
+    // освобождают свой буфер. Опубликованный сегмент больше не меняется до разрушения вектора
+    Slot* EnsureSegment(size_t k) {
+        assert(k < MAX_SEGMENTS);
+        Slot* segment = published_[k].load(std::memory_order_acquire);
+        if (segment != nullptr) return segment;
+        RawMemory<Slot, SlotAllocator> new_segment(SegmentSize(k));
+        std::uninitialized_default_construct_n(new_segment.GetAddress(), SegmentSize(k));
+        Slot* expected = nullptr;
+        if (published_[k].compare_exchange_strong(expected, new_segment.GetAddress(), std::memory_order_acq_rel)) {
+            segments_[k] = std::move(new_segment);
+            return published_[k].load(std::memory_order_relaxed);
+        }
+        std::destroy_n(new_segment.GetAddress(), SegmentSize(k));
+        return expected;
+    }
+};
@@ -0,0 +1,252 @@
+
+#pragma once
+
+#include "vector.h"
+
+// Вектор, который при росте не переносит все элементы сразу. Старый буфер живет рядом с новым, и
+// каждое следующее добавление переносит в новый буфер ограниченное число элементов, как при
+// постепенном рехешировании хеш-таблицы. Шаг подбирается так, чтобы перенос закончился, пока новый
+// буфер не заполнится, поэтому самое долгое добавление стоит O(1) переносов вместо O(n).
+// Пока перенос не закончен, operator[] выбирает буфер по индексу, а элементы не лежат подряд:
+// Data() сначала завершает перенос целиком
+template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
+class IncrementalVector {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using iterator = detail::IndexIterator<IncrementalVector>;
+    using const_iterator = detail::IndexIterator<const IncrementalVector>;
+
+    iterator begin() noexcept { return {this, 0}; }
+    iterator end() noexcept { return {this, size_}; }
+    const_iterator cbegin() const noexcept { return {this, 0}; }
+    const_iterator cend() const noexcept { return {this, size_}; }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    IncrementalVector() = default;
+
+    explicit IncrementalVector(const Allocator& alloc) noexcept
+        : new_(alloc)
+        , old_(alloc) {}
+
+    // Делегирующие конструкторы: если создание элемента бросит исключение, деструктор уничтожит
+    // уже созданные
+    explicit IncrementalVector(size_t size, const Allocator& alloc = Allocator())
+        : IncrementalVector(alloc) {
+        Resize(size);
+    }
+
+    IncrementalVector(const IncrementalVector& other)
+        : IncrementalVector(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.GetAllocator())) {
+        Reserve(other.size_);
+        for (const T& value : other) {
+            EmplaceBack(value);
+        }
+    }
+
+    IncrementalVector(IncrementalVector&& other) noexcept
+        : new_(std::move(other.new_))
+        , old_(std::move(other.old_))
+        , migrated_(std::exchange(other.migrated_, 0))
+        , old_count_(std::exchange(other.old_count_, 0))
+        , step_(other.step_)
+        , size_(std::exchange(other.size_, 0)) {}
+
+    IncrementalVector& operator=(const IncrementalVector& other) {
+        if (this != &other) {
+            IncrementalVector copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    IncrementalVector& operator=(IncrementalVector&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    ~IncrementalVector() {
+        Clear();
+    }
+
+    // Выделяет новый буфер и начинает постепенный перенос в него. Незаконченный перенос в прежний
+    // буфер сначала завершается
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) return;
+        FinishMigration();
+        StartMigration(new_capacity);
+    }
+
+    void Resize(size_t new_size) {
+        while (size_ > new_size) {
+            PopBack();
+        }
+        while (size_ < new_size) {
+            EmplaceBack();
+        }
+    }
+
+    // Элемент создается до переноса очередной порции, поэтому аргументы могут ссылаться на элементы
+    // вектора. Если перенос бросит исключение, созданный элемент уничтожается, а вектор не меняется
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            // Каждое добавление уменьшает свободное место на один элемент, а остаток переноса на step_,
+            // поэтому к заполнению буфера перенос окончен. Смена буфера не трогает элементы, и
+            // аргументы, ссылающиеся на них, остаются действительными
+            assert(!IsMigrating());
+            StartMigration(GrowthPolicy::NextCapacity(Capacity(), size_ + 1, sizeof(T)));
+        }
+        T* slot = new_.GetAddress() + size_;
+        new (slot) T(std::forward<Args>(args)...);
+        try {
+            Migrate(step_);
+        } catch (...) {
+            std::destroy_at(slot);
+            throw;
+        }
+        ++size_;
+        return *slot;
+    }
+
+    template <typename S>
+    void PushBack(S&& value) {
+        EmplaceBack(std::forward<S>(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_);
+        --size_;
+        std::destroy_at(&Locate(size_));
+        if (size_ < old_count_) {
+            // Последний элемент еще не был перенесен
+            old_count_ = size_;
+            MaybeReleaseOld();
+        }
+    }
+
+    void Clear() noexcept {
+        ForEachSegment([](T* data, size_t count) {
+            std::destroy_n(data, count);
+        });
+        size_ = 0;
+        old_count_ = migrated_;
+        MaybeReleaseOld();
+    }
+
+    // Переносит все оставшиеся элементы и освобождает старый буфер
+    void FinishMigration() {
+        Migrate(old_count_ - migrated_);
+    }
+
+    bool IsMigrating() const noexcept {
+        return migrated_ < old_count_;
+    }
+
+    void Swap(IncrementalVector& other) noexcept {
+        new_.Swap(other.new_);
+        old_.Swap(other.old_);
+        std::swap(migrated_, other.migrated_);
+        std::swap(old_count_, other.old_count_);
+        std::swap(step_, other.step_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return new_.Capacity();
+    }
+
+    // Завершает перенос, поэтому может занять O(n) и бросить исключение, если элементы копируются
+    T* Data() {
+        FinishMigration();
+        return new_.GetAddress();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<IncrementalVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Locate(index);
+    }
+
+    // Вызывает f(data, count) для каждого непрерывного участка элементов по порядку. Пока перенос
+    // не закончен, участков три, иначе один
+    template <typename F>
+    void ForEachSegment(F f) {
+        if (migrated_ != 0) {
+            f(new_.GetAddress(), migrated_);
+        }
+        if (old_count_ != migrated_) {
+            f(old_.GetAddress() + migrated_, old_count_ - migrated_);
+        }
+        if (size_ != old_count_) {
+            f(new_.GetAddress() + old_count_, size_ - old_count_);
+        }
+    }
+
+    template <typename F>
+    void ForEachSegment(F f) const {
+        const_cast<IncrementalVector&>(*this).ForEachSegment([&f](T* data, size_t count) {
+            f(static_cast<const T*>(data), count);
+        });
+    }
+
+    const Allocator& GetAllocator() const noexcept {
+        return new_.GetAllocator();
+    }
+
+private:
+    RawMemory<T, Allocator> new_;
+    RawMemory<T, Allocator> old_;
+    size_t migrated_ = 0;
+    size_t old_count_ = 0;
+    // Сколько элементов переносит каждое добавление
+    size_t step_ = 0;
+    size_t size_ = 0;
+
+    // Делает новый буфер старым. Элементы переносятся с начала, а они занимают
+    // [0, size_) старого буфера, поэтому все индексы пока указывают в него
+    void StartMigration(size_t new_capacity) {
+        RawMemory<T, Allocator> new_data(new_capacity, new_.GetAllocator());
+        old_.Swap(new_);
+        new_.Swap(new_data);
+        migrated_ = 0;
+        old_count_ = size_;
+        // Перенос должен закончиться за room добавлений
+        const size_t room = new_capacity - size_;
+        step_ = (size_ + room - 1) / room;
+        MaybeReleaseOld();
+    }
+
+    // Переносит до count элементов. Если перенос бросает исключение, эта порция остается в старом
+    // буфере, и вектор не меняется
+    void Migrate(size_t count) {
+        count = std::min(count, old_count_ - migrated_);
+        if (count == 0) return;
+        detail::UninitializedRelocateN(old_.GetAddress() + migrated_, count, new_.GetAddress() + migrated_);
+        migrated_ += count;
+        MaybeReleaseOld();
+    }
+
+    // Элементы [migrated_, old_count_) еще лежат в старом буфере, остальные уже в новом
+    T& Locate(size_t index) noexcept {
+        return index >= migrated_ && index < old_count_ ? old_[index] : new_[index];
+    }
+
+    void MaybeReleaseOld() noexcept {
+        if (migrated_ < old_count_) return;
+        RawMemory<T, Allocator>(old_.GetAllocator()).Swap(old_);
+        migrated_ = 0;
+        old_count_ = 0;
+    }
+};
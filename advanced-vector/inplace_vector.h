@@ -0,0 +1,239 @@
+
+#pragma once
+
+#include <new>
+
+#include "vector.h"
+
+namespace detail {
+
+// Место под N элементов внутри объекта и число созданных в нем элементов
+template <typename T, size_t N>
+struct InplaceBuffer {
+    T* Data() noexcept {
+        return std::launder(reinterpret_cast<T*>(bytes));
+    }
+
+    const T* Data() const noexcept {
+        return std::launder(reinterpret_cast<const T*>(bytes));
+    }
+
+    size_t size = 0;
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+};
+
+// Буфер, копирование и уничтожение которого поэлементно вызывают конструкторы и деструкторы T
+template <typename T, size_t N>
+struct InplaceElements : InplaceBuffer<T, N> {
+    InplaceElements() = default;
+
+    InplaceElements(const InplaceElements& other) {
+        std::uninitialized_copy_n(other.Data(), other.size, this->Data());
+        this->size = other.size;
+    }
+
+    // Как и у std::inplace_vector, элементы источника остаются на месте в перемещенном состоянии
+    InplaceElements(InplaceElements&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        std::uninitialized_move_n(other.Data(), other.size, this->Data());
+        this->size = other.size;
+    }
+
+    InplaceElements& operator=(const InplaceElements& other) {
+        if (this != &other) {
+            Assign(other.Data(), other.size);
+        }
+        return *this;
+    }
+
+    InplaceElements& operator=(InplaceElements&& other) noexcept(std::is_nothrow_move_assignable_v<T>
+                                                                 && std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            Assign(std::make_move_iterator(other.Data()), other.size);
+        }
+        return *this;
+    }
+
+    ~InplaceElements() {
+        std::destroy_n(this->Data(), this->size);
+    }
+
+private:
+    template <typename InputIt>
+    void Assign(InputIt src_begin, size_t src_size) {
+        T* data = this->Data();
+        std::copy_n(src_begin, std::min(this->size, src_size), data);
+        if (this->size <= src_size) {
+            std::uninitialized_copy_n(std::next(src_begin, this->size), src_size - this->size, data + this->size);
+        } else {
+            std::destroy_n(data + src_size, this->size - src_size);
+        }
+        this->size = src_size;
+    }
+};
+
+// Для тривиально копируемых T достаточно скопировать байты, и сам буфер тоже тривиально копируемый
+template <typename T, size_t N>
+using InplaceStorage = std::conditional_t<std::is_trivially_copyable_v<T>, InplaceBuffer<T, N>, InplaceElements<T, N>>;
+
+}  // namespace detail
+
+// Вектор фиксированной емкости N с элементами внутри объекта: память в куче не выделяется никогда.
+// Вставка и удаление выполняются теми же функциями, что и в Vector. При нехватке места EmplaceBack,
+// Emplace, Insert и Resize бросают std::bad_alloc, не меняя вектор, а TryEmplaceBack возвращает nullptr.
+// Если T тривиально копируемый, InplaceVector тоже тривиально копируемый
+template <typename T, size_t N>
+class InplaceVector {
+    static_assert(N > 0, "Capacity must be positive");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    iterator begin() noexcept { return storage_.Data(); }
+    iterator end() noexcept { return storage_.size + begin(); }
+    const_iterator cbegin() const noexcept { return storage_.Data(); }
+    const_iterator cend() const noexcept { return storage_.size + cbegin(); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    InplaceVector() = default;
+
+    explicit InplaceVector(size_t size) {
+        Resize(size);
+    }
+
+    void Resize(size_t new_size) {
+        CheckCapacity(new_size);
+        const size_t size = storage_.size;
+        if (new_size < size) {
+            std::destroy_n(begin() + new_size, size - new_size);
+        } else {
+            std::uninitialized_value_construct_n(end(), new_size - size);
+        }
+        storage_.size = new_size;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        CheckCapacity(storage_.size + 1);
+        return *UncheckedEmplaceBack(std::forward<Args>(args)...);
+    }
+
+    template <typename S>
+    void PushBack(S&& value) {
+        EmplaceBack(std::forward<S>(value));
+    }
+
+    // Возвращает новый элемент или nullptr, если вектор заполнен. Исключения конструктора T
+    // не перехватываются
+    template <typename... Args>
+    T* TryEmplaceBack(Args&&... args) {
+        return storage_.size < N ? UncheckedEmplaceBack(std::forward<Args>(args)...) : nullptr;
+    }
+
+    template <typename S>
+    T* TryPushBack(S&& value) {
+        return TryEmplaceBack(std::forward<S>(value));
+    }
+
+    void PopBack() noexcept {
+        assert(storage_.size);
+        std::destroy_at(begin() + --storage_.size);
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        assert(pos >= begin() && pos <= end());
+        const size_t new_pos = pos - begin();
+        CheckCapacity(storage_.size + 1);
+        detail::EmplaceInCapacity(begin(), storage_.size, new_pos, std::forward<Args>(args)...);
+        ++storage_.size;
+        return begin() + new_pos;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) {
+        assert(pos >= begin() && pos < end());
+        const size_t new_pos = pos - begin();
+        detail::EraseAt(begin(), storage_.size, new_pos);
+        --storage_.size;
+        return begin() + new_pos;
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        assert(first >= begin() && first <= last && last <= end());
+        const size_t new_pos = first - begin();
+        if (first != last) {
+            detail::EraseRange(begin(), storage_.size, new_pos, last - first);
+            storage_.size -= last - first;
+        }
+        return begin() + new_pos;
+    }
+
+    void Clear() noexcept {
+        std::destroy_n(begin(), storage_.size);
+        storage_.size = 0;
+    }
+
+    // Обменивает общую часть элементов, а лишние элементы большего вектора переносит в меньший
+    void Swap(InplaceVector& other) noexcept(std::is_nothrow_swappable_v<T> && std::is_nothrow_move_constructible_v<T>) {
+        if (storage_.size > other.storage_.size) {
+            other.Swap(*this);
+            return;
+        }
+        const size_t size = storage_.size;
+        std::swap_ranges(begin(), end(), other.begin());
+        std::uninitialized_move(other.begin() + size, other.end(), end());
+        std::destroy(other.begin() + size, other.end());
+        std::swap(storage_.size, other.storage_.size);
+    }
+
+    size_t Size() const noexcept {
+        return storage_.size;
+    }
+
+    static constexpr size_t Capacity() noexcept {
+        return N;
+    }
+
+    T* Data() noexcept {
+        return begin();
+    }
+
+    const T* Data() const noexcept {
+        return begin();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<InplaceVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < storage_.size);
+        return begin()[index];
+    }
+
+private:
+    detail::InplaceStorage<T, N> storage_;
+
+    static void CheckCapacity(size_t required) {
+        if (required > N) {
+            throw std::bad_alloc();
+        }
+    }
+
+    template <typename... Args>
+    T* UncheckedEmplaceBack(Args&&... args) {
+        T* slot = new (end()) T(std::forward<Args>(args)...);
+        ++storage_.size;
+        return slot;
+    }
+};
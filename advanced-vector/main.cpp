@@ -1,11 +1,37 @@
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "allocators.h"
+#include "concurrent_vector.h"
+#include "incremental_vector.h"
+#include "inplace_vector.h"
+#include "mapped_vector.h"
+#include "mmap_allocator.h"
+#include "parallel_collector.h"
+#include "shared_vector.h"
+#include "small_vector.h"
+#include "soa_vector.h"
+#include "sorted_vector.h"
+#include "stable_vector.h"
 #include "vector.h"
+#include "vector_algorithms.h"
+#include "vector_io.h"
+#include "vector_pool.h"
+#include "vector_stats.h"
 
 namespace {
 
@@ -118,8 +144,205 @@ struct Obj {
     static inline int num_move_assigned = 0;
 };
 
+template <typename T, bool Propagate>
+struct TrackingAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_move_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_swap = std::bool_constant<Propagate>;
+
+    explicit TrackingAllocator(int id)
+        : id(id)  //
+    {
+    }
+
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U, Propagate>& other)
+        : id(other.id)  //
+    {
+    }
+
+    T* allocate(size_t n) {
+        ++num_allocations;
+        return static_cast<T*>(operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t /*n*/) noexcept {
+        ++num_deallocations;
+        operator delete(p);
+    }
+
+    bool operator==(const TrackingAllocator& other) const noexcept {
+        return id == other.id;
+    }
+
+    bool operator!=(const TrackingAllocator& other) const noexcept {
+        return id != other.id;
+    }
+
+    static void ResetCounters() {
+        num_allocations = 0;
+        num_deallocations = 0;
+    }
+
+    int id = 0;
+
+    static inline int num_allocations = 0;
+    static inline int num_deallocations = 0;
+};
+
+struct RelocatableObj {
+    RelocatableObj() {
+        ++num_alive;
+    }
+    RelocatableObj(const RelocatableObj& /*other*/) {
+        ++num_alive;
+        ++num_copied;
+    }
+    RelocatableObj(RelocatableObj&& /*other*/) noexcept {
+        ++num_alive;
+        ++num_moved;
+    }
+    RelocatableObj& operator=(const RelocatableObj& /*other*/) = default;
+    RelocatableObj& operator=(RelocatableObj&& /*other*/) noexcept = default;
+    ~RelocatableObj() {
+        --num_alive;
+    }
+
+    static void ResetCounters() {
+        num_alive = 0;
+        num_copied = 0;
+        num_moved = 0;
+    }
+
+    RelocatableObj* self = this;
+
+    static inline int num_alive = 0;
+    static inline int num_copied = 0;
+    static inline int num_moved = 0;
+};
+
+struct ThrowingMoveObj {
+    ThrowingMoveObj() {
+        ++num_alive;
+    }
+    ThrowingMoveObj(const ThrowingMoveObj& other)
+        : id(other.id)  //
+    {
+        if (copy_throw_countdown > 0 && --copy_throw_countdown == 0) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+    ThrowingMoveObj(ThrowingMoveObj&& other)
+        : id(other.id)  //
+    {
+        ++num_alive;
+        ++num_moved;
+    }
+    explicit ThrowingMoveObj(int id)
+        : id(id)  //
+    {
+        ++num_alive;
+    }
+    ThrowingMoveObj& operator=(const ThrowingMoveObj& other) = default;
+    ThrowingMoveObj& operator=(ThrowingMoveObj&& other) = default;
+    ~ThrowingMoveObj() {
+        --num_alive;
+    }
+
+    int id = 0;
+
+    static inline int copy_throw_countdown = 0;
+    static inline int num_alive = 0;
+    static inline int num_moved = 0;
+};
+
+template <typename T>
+struct ReallocCountingAllocator : MallocAllocator<T> {
+    ReallocCountingAllocator() = default;
+
+    template <typename U>
+    ReallocCountingAllocator(const ReallocCountingAllocator<U>& /*other*/) noexcept {}
+
+    T* allocate(size_t n) {
+        ++num_allocations;
+        return MallocAllocator<T>::allocate(n);
+    }
+
+    T* reallocate(T* p, size_t old_n, size_t new_n) noexcept {
+        ++num_reallocations;
+        return MallocAllocator<T>::reallocate(p, old_n, new_n);
+    }
+
+    static inline int num_allocations = 0;
+    static inline int num_reallocations = 0;
+};
+
+// Счетчики атомарные, потому что элементы создаются и уничтожаются в нескольких потоках
+struct ParallelObj {
+    ParallelObj() {
+        if (default_construction_throw_countdown.load() > 0 && default_construction_throw_countdown.fetch_sub(1) == 1) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+    ParallelObj(const ParallelObj& other)
+        : id(other.id)  //
+    {
+        if (other.throw_on_copy) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+    // Перемещение не noexcept: Reserve копирует элементы
+    ParallelObj(ParallelObj&& other)
+        : id(other.id)  //
+    {
+        ++num_alive;
+    }
+    ParallelObj& operator=(const ParallelObj& other) = default;
+    ~ParallelObj() {
+        --num_alive;
+    }
+
+    int id = 0;
+    bool throw_on_copy = false;
+
+    static inline std::atomic<int> default_construction_throw_countdown = 0;
+    static inline std::atomic<int> num_alive = 0;
+};
+
+struct ObjStatsTag {
+    static constexpr const char* NAME = "test objects";
+};
+
+struct FallbackStatsTag {
+    static constexpr const char* NAME = "copy fallback";
+};
+
+struct LateStatsTag {
+    static constexpr const char* NAME = "late";
+};
+
+// Создается раньше реестра счетчиков и уничтожается после выхода из main
+struct LateStatsUser {
+    ~LateStatsUser() {
+        values.PushBack(1);
+        std::ostringstream out;
+        VectorStatsRegistry::Instance().Dump(out);
+        assert(out.str().find("late: allocations=1 ") != std::string::npos);
+    }
+
+    Vector<int, std::allocator<int>, DoublingGrowth, VectorStats<LateStatsTag>> values;
+};
+
 }  // namespace
 
+// Побайтовый перенос корректен, если не полагаться на значение self после реаллокации
+template <>
+struct IsTriviallyRelocatable<RelocatableObj> : std::true_type {};
+
 void Test1() {
     Obj::ResetCounters();
     const size_t SIZE = 100500;
@@ -560,85 +783,2218 @@ void Test6() {
     }
 }
 
-struct C {
-    C() noexcept {
-        ++def_ctor;
+void Test7() {
+    const size_t SIZE = 10;
+    const int ID = 42;
+    using PropagatingAlloc = TrackingAllocator<Obj, true>;
+    using StickyAlloc = TrackingAllocator<Obj, false>;
+    {
+        PropagatingAlloc::ResetCounters();
+        Vector<Obj, PropagatingAlloc> v(SIZE, PropagatingAlloc{1});
+        assert(v.GetAllocator().id == 1);
+        assert(PropagatingAlloc::num_allocations == 1);
+        v.PushBack(Obj{ID});
+        assert(PropagatingAlloc::num_allocations == 2);
+        assert(PropagatingAlloc::num_deallocations == 1);
+        const auto v_copy(v);
+        assert(v_copy.GetAllocator().id == 1);
+        assert(v_copy[SIZE].id == ID);
+    }
+    assert(PropagatingAlloc::num_allocations == PropagatingAlloc::num_deallocations);
+    {
+        Obj::ResetCounters();
+        Vector<Obj, PropagatingAlloc> v1(SIZE, PropagatingAlloc{1});
+        Vector<Obj, PropagatingAlloc> v2(SIZE * 2, PropagatingAlloc{2});
+        v1[0].id = ID;
+        v2 = v1;
+        assert(v2.GetAllocator().id == 1);
+        assert(v2.Size() == SIZE);
+        assert(v2.Capacity() == SIZE);
+        assert(v2[0].id == ID);
+
+        Vector<Obj, PropagatingAlloc> v3(PropagatingAlloc{3});
+        v3 = std::move(v1);
+        assert(v3.GetAllocator().id == 1);
+        assert(v3[0].id == ID);
+        assert(Obj::num_moved == 0);
+
+        v3.Swap(v2);
+        assert(v2.GetAllocator().id == 1);
+        assert(v3.GetAllocator().id == 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        StickyAlloc::ResetCounters();
+        Vector<Obj, StickyAlloc> v1(SIZE, StickyAlloc{1});
+        Vector<Obj, StickyAlloc> v2(SIZE / 2, StickyAlloc{2});
+        v1[SIZE - 1].id = ID;
+        v2 = v1;
+        assert(v2.GetAllocator().id == 2);
+        assert(v2.Size() == SIZE);
+        assert(v2[SIZE - 1].id == ID);
+
+        Vector<Obj, StickyAlloc> v3(StickyAlloc{3});
+        const int old_move_count = Obj::num_moved;
+        v3 = std::move(v1);
+        // Буфер с чужим аллокатором забрать нельзя, элементы перемещаются по одному
+        assert(v3.GetAllocator().id == 3);
+        assert(v3.Size() == SIZE);
+        assert(v3[SIZE - 1].id == ID);
+        assert(Obj::num_moved == old_move_count + static_cast<int>(SIZE));
     }
-    C(const C& /*other*/) noexcept {
-        ++copy_ctor;
+    assert(Obj::GetAliveObjectCount() == 0);
+    assert(StickyAlloc::num_allocations == StickyAlloc::num_deallocations);
+}
+
+void Test8() {
+    const size_t SIZE = 100;
+    {
+        static_assert(IsTriviallyRelocatable<int>::value);
+        static_assert(IsTriviallyRelocatable<std::unique_ptr<int>>::value);
+        static_assert(!IsTriviallyRelocatable<std::string>::value);
+        static_assert(!IsTriviallyRelocatable<Obj>::value);
     }
-    C(C&& /*other*/) noexcept {
-        ++move_ctor;
+    {
+        RelocatableObj::ResetCounters();
+        Vector<RelocatableObj> v(SIZE);
+        v.Emplace(v.begin() + 1);
+        v.Reserve(SIZE * 4);
+        v.Resize(SIZE * 5);
+        v.PushBack(v[0]);
+        // Реаллокации переносят элементы без вызова конструкторов и деструкторов
+        assert(v.Size() == SIZE * 5 + 1);
+        assert(RelocatableObj::num_moved == 0);
+        assert(RelocatableObj::num_copied == 1);
+        assert(RelocatableObj::num_alive == static_cast<int>(SIZE * 5 + 1));
     }
-    C& operator=(const C& other) noexcept {
-        if (this != &other) {
-            ++copy_assign;
+    assert(RelocatableObj::num_alive == 0);
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.EmplaceBack(std::make_unique<int>(i));
+        }
+        v.Emplace(v.begin(), std::make_unique<int>(-1));
+        assert(*v[0] == -1);
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            assert(*v[i + 1] == i);
         }
-        return *this;
     }
-    C& operator=(C&& /*other*/) noexcept {
-        ++move_assign;
-        return *this;
+    {
+        Vector<int> v;
+        std::vector<int> expected;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.Insert(v.begin() + v.Size() / 2, i);
+            expected.insert(expected.begin() + expected.size() / 2, i);
+        }
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
     }
-    ~C() {
-        ++dtor;
+    {
+        // Конструктор перемещения не noexcept: при реаллокации элементы копируются,
+        // а исключение при копировании оставляет вектор нетронутым
+        ThrowingMoveObj::num_alive = 0;
+        ThrowingMoveObj::num_moved = 0;
+        Vector<ThrowingMoveObj> v(SIZE);
+        v[SIZE - 1].id = 1;
+        ThrowingMoveObj::copy_throw_countdown = SIZE / 2;
+        try {
+            v.EmplaceBack(2);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        assert(v[SIZE - 1].id == 1);
+        ThrowingMoveObj::copy_throw_countdown = SIZE / 2;
+        try {
+            v.Emplace(v.begin() + SIZE / 4, 2);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(ThrowingMoveObj::num_alive == static_cast<int>(SIZE));
+        assert(ThrowingMoveObj::num_moved == 0);
+        v.Emplace(v.begin() + 1, 2);
+        assert(v.Size() == SIZE + 1);
+        assert(v[1].id == 2);
+        assert(v[SIZE].id == 1);
+        assert(ThrowingMoveObj::num_moved == 0);
     }
+    assert(ThrowingMoveObj::num_alive == 0);
+}
 
-    static void Reset() {
-        def_ctor = 0;
-        copy_ctor = 0;
-        move_ctor = 0;
-        copy_assign = 0;
-        move_assign = 0;
-        dtor = 0;
+void Test9() {
+    const size_t SIZE = 1 << 20;
+    {
+        using Alloc = ReallocCountingAllocator<int>;
+        Vector<int, Alloc> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        v.Emplace(v.begin(), -1);
+        v.Reserve(SIZE * 4);
+        assert(v.Size() == SIZE + 1);
+        assert(v.Capacity() == SIZE * 4);
+        assert(v[0] == -1);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i + 1] == static_cast<int>(i));
+        }
+        // Только первый буфер выделен заново, дальше емкость растет через reallocate
+        assert(Alloc::num_allocations == 1);
+        assert(Alloc::num_reallocations == 22);
+    }
+    {
+        Vector<std::unique_ptr<int>, MallocAllocator<std::unique_ptr<int>>> v;
+        v.EmplaceBack(std::make_unique<int>(1));
+        v.PushBack(std::move(v[0]));
+        v.Emplace(v.begin(), std::make_unique<int>(0));
+        assert(v.Size() == 3);
+        assert(*v[0] == 0);
+        assert(v[1] == nullptr);
+        assert(*v[2] == 1);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj, MallocAllocator<Obj>> v(10);
+        v.Reserve(100);
+        assert(Obj::num_moved == 10);
     }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
 
-    inline static size_t def_ctor = 0;
-    inline static size_t copy_ctor = 0;
-    inline static size_t move_ctor = 0;
-    inline static size_t copy_assign = 0;
-    inline static size_t move_assign = 0;
-    inline static size_t dtor = 0;
-};
+void Test10() {
+    {
+        Vector<int, std::allocator<int>, GeometricGrowth<3, 2, 16>> v;
+        v.PushBack(1);
+        assert(v.Capacity() == 16);
+        v.Resize(16);
+        v.PushBack(2);
+        assert(v.Capacity() == 24);
+        v.Emplace(v.begin(), 3);
+        v.Resize(24);
+        v.Emplace(v.begin(), 4);
+        assert(v.Capacity() == 36);
+        v.Resize(100);
+        assert(v.Capacity() == 100);
+    }
+    {
+        using Growth = SizeClassGrowth<GeometricGrowth<3, 2>>;
+        assert(Growth::RoundUpToSizeClass(1) == 8);
+        assert(Growth::RoundUpToSizeClass(17) == 32);
+        assert(Growth::RoundUpToSizeClass(65) == 80);
+        assert(Growth::RoundUpToSizeClass(129) == 160);
+        assert(Growth::RoundUpToSizeClass(4096) == 4096);
+        assert(Growth::RoundUpToSizeClass(4097) == 5120);
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor              //
-         << ", Copy ctors: "sv << C::copy_ctor          //
-         << ", Move ctors: "sv << C::move_ctor          //
-         << ", Copy assignments: "sv << C::copy_assign  //
-         << ", Move assignments: "sv << C::move_assign  //
-         << ", Dtors: "sv << C::dtor << endl;
+        Vector<char, std::allocator<char>, Growth> v;
+        std::vector<size_t> capacities;
+        for (int i = 0; i < 300; ++i) {
+            if (v.Size() == v.Capacity()) {
+                v.PushBack('a');
+                capacities.push_back(v.Capacity());
+            } else {
+                v.PushBack('a');
+            }
+        }
+        assert((capacities == std::vector<size_t>{8, 16, 32, 48, 80, 128, 192, 320}));
+    }
+    {
+        struct Triple {
+            int a, b, c;
+        };
+        Vector<Triple, std::allocator<Triple>, SizeClassGrowth<>> v;
+        v.PushBack(Triple{1, 2, 3});
+        // 12 байт округляются до 16, поэтому лишнего места хватает лишь на один элемент
+        assert(v.Capacity() == 1);
+        v.PushBack(Triple{4, 5, 6});
+        assert(v.Capacity() == 2);
+        v.PushBack(Triple{7, 8, 9});
+        assert(v.Capacity() == 4);
+        assert(v[2].c == 9);
+    }
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            Dump();
-            v.push_back(c);
+void Test11() {
+    const size_t N = 16;
+    const int ID = 42;
+    using namespace std::literals;
+    using Alloc = TrackingAllocator<Obj, false>;
+    {
+        Obj::ResetCounters();
+        Alloc::ResetCounters();
+        SmallVector<Obj, N, Alloc> v(Alloc{1});
+        assert(v.Capacity() == N);
+        assert(v.IsInline());
+        for (size_t i = 0; i < N; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
         }
-        Dump();
-    } catch (...) {
+        v.Insert(v.begin() + 1, Obj{ID});
+        // Переполнение внутреннего буфера
+        assert(Alloc::num_allocations == 1);
+        assert(!v.IsInline());
+        assert(v.Size() == N + 1);
+        assert(v.Capacity() == N * 2);
+        assert(v[1].id == ID);
+        assert(v[N].id == static_cast<int>(N - 1));
+        v.Erase(v.begin() + 1);
+        assert(v[1].id == 1);
+        assert(Obj::num_copied == 0);
     }
-    try {
-        const size_t NUM = 10;
-        C c;
+    assert(Obj::GetAliveObjectCount() == 0);
+    assert(Alloc::num_deallocations == 1);
+    {
+        Alloc::ResetCounters();
+        SmallVector<Obj, N, Alloc> v(N / 2, Alloc{1});
+        v.EmplaceBack(ID, "Ivan"s);
+        v.Emplace(v.begin(), ID + 1, "Petr"s);
+        v.PushBack(v[0]);
+        v.Emplace(v.begin() + 2, std::move(v[N / 2 + 1]));
+        assert(v.Size() == N / 2 + 4);
+        assert(v[0].name == "Petr"s);
+        assert(v[2].id == ID);
+        assert(v[N / 2 + 3].id == ID + 1);
+        v.Reserve(N);
+        assert(v.IsInline());
+        SmallVector<Obj, N, Alloc> moved(std::move(v));
+        assert(moved.Size() == N / 2 + 4);
+        assert(moved[0].id == ID + 1);
+        assert(v.Size() == 0);
+        assert(Alloc::num_allocations == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, N> small(N / 2);
+        SmallVector<Obj, N> large(N * 2);
+        small[0].id = 1;
+        large[0].id = 2;
+        const Obj* large_data = &large[0];
+        small.Swap(large);
+        assert(small.Size() == N * 2);
+        assert(&small[0] == large_data);
+        assert(large.Size() == N / 2);
+        assert(large.IsInline());
+        assert(small[0].id == 2 && large[0].id == 1);
+
+        large = small;
+        assert(large.Size() == N * 2);
+        assert(large[0].id == 2);
+        small = SmallVector<Obj, N>(N / 4);
+        assert(small.Size() == N / 4);
+        small.Resize(N * 4);
+        assert(small.Size() == N * 4);
+        assert(small.Capacity() == N * 4);
+        small.Resize(1);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(N * 2 + 1));
+        assert(Obj::num_copied == static_cast<int>(N * 2));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Аллокатор распространяется так же, как у Vector
+        using PropagatingAlloc = TrackingAllocator<Obj, true>;
+        using SV = SmallVector<Obj, N, PropagatingAlloc>;
+        Obj::ResetCounters();
+        PropagatingAlloc::ResetCounters();
+        SV inline_v(N / 2, PropagatingAlloc{1});
+        SV heap_v(N * 2, PropagatingAlloc{2});
+        inline_v[0].id = ID;
+        heap_v[0].id = ID + 1;
+
+        SV copy(PropagatingAlloc{3});
+        copy = inline_v;
+        assert(copy.GetAllocator().id == 1);
+        assert(copy.IsInline() && copy.Size() == N / 2 && copy[0].id == ID);
+        copy = heap_v;
+        assert(copy.GetAllocator().id == 2);
+        assert(copy.Size() == N * 2 && copy[0].id == ID + 1);
+
+        SV moved(N * 2, PropagatingAlloc{4});
+        moved = std::move(inline_v);
+        assert(moved.GetAllocator().id == 1);
+        assert(moved.Size() == N / 2 && moved[0].id == ID);
+        assert(inline_v.Size() == 0);
+
+        moved.Swap(heap_v);
+        assert(moved.GetAllocator().id == 2 && heap_v.GetAllocator().id == 1);
+        assert(moved.Size() == N * 2 && moved[0].id == ID + 1);
+        assert(heap_v.Size() == N / 2 && heap_v[0].id == ID);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    assert((TrackingAllocator<Obj, true>::num_allocations == TrackingAllocator<Obj, true>::num_deallocations));
+    {
+        Obj::ResetCounters();
+        Alloc::ResetCounters();
+        SmallVector<Obj, N, Alloc> v1(N / 2, Alloc{1});
+        SmallVector<Obj, N, Alloc> v2(N * 2, Alloc{2});
+        v1 = v2;
+        assert(v1.GetAllocator().id == 1 && v1.Size() == N * 2);
+        SmallVector<Obj, N, Alloc> v3(Alloc{3});
+        v3 = std::move(v2);
+        assert(v3.GetAllocator().id == 3 && v3.Size() == N * 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    assert(Alloc::num_allocations == Alloc::num_deallocations);
+    {
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = N / 2;
+        try {
+            SmallVector<Obj, N> v(N);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        SmallVector<Obj, N> v(N);
+        v[N / 2].throw_on_copy = true;
+        try {
+            SmallVector<Obj, N> v_copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+            assert(Obj::num_copied == static_cast<int>(N / 2));
+        }
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(N));
+        v.Reserve(N * 2);
+        assert(v.Size() == N);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(N));
+    }
+    {
+        ThrowingMoveObj::num_alive = 0;
+        SmallVector<ThrowingMoveObj, N> v(N);
+        ThrowingMoveObj::copy_throw_countdown = N / 2;
+        try {
+            v.EmplaceBack(ID);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.IsInline());
+        assert(v.Size() == N);
+        assert(ThrowingMoveObj::num_alive == static_cast<int>(N));
+    }
+    assert(ThrowingMoveObj::num_alive == 0);
+    {
+        // Перенос из внутреннего буфера копирует элементы, и если копирование бросит исключение,
+        // источник не меняется
+        using SV = SmallVector<ThrowingMoveObj, N>;
+        const auto make = [](size_t size, int first_id) {
+            SV v;
+            for (size_t i = 0; i < size; ++i) {
+                v.EmplaceBack(first_id + static_cast<int>(i));
+            }
+            return v;
+        };
+        const auto has_ids = [](const SV& v, size_t size, int first_id) {
+            if (v.Size() != size) return false;
+            for (size_t i = 0; i < size; ++i) {
+                if (v[i].id != first_id + static_cast<int>(i)) return false;
+            }
+            return true;
+        };
+        ThrowingMoveObj::num_alive = 0;
         {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            Dump();
-            v.PushBack(c);
+            SV heap_v = make(N * 2, 100);
+            SV inline_v = make(N / 2, 0);
+            ThrowingMoveObj::copy_throw_countdown = N / 4;
+            try {
+                heap_v = std::move(inline_v);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            ThrowingMoveObj::copy_throw_countdown = 0;
+            assert(inline_v.IsInline() && has_ids(inline_v, N / 2, 0));
+            assert(heap_v.Size() == 0);
+            assert(ThrowingMoveObj::num_alive == static_cast<int>(N / 2));
+
+            heap_v = make(N * 2, 100);
+            ThrowingMoveObj::copy_throw_countdown = N / 4;
+            try {
+                inline_v.Swap(heap_v);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(inline_v.IsInline() && has_ids(inline_v, N / 2, 0));
+            assert(!heap_v.IsInline() && has_ids(heap_v, N * 2, 100));
+            ThrowingMoveObj::copy_throw_countdown = N / 4;
+            try {
+                heap_v.Swap(inline_v);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            ThrowingMoveObj::copy_throw_countdown = 0;
+            assert(inline_v.IsInline() && has_ids(inline_v, N / 2, 0));
+            assert(!heap_v.IsInline() && has_ids(heap_v, N * 2, 100));
+            assert(ThrowingMoveObj::num_alive == static_cast<int>(N / 2 + N * 2));
+
+            inline_v.Swap(heap_v);
+            assert(!inline_v.IsInline() && has_ids(inline_v, N * 2, 100));
+            assert(heap_v.IsInline() && has_ids(heap_v, N / 2, 0));
+            SV other_inline = make(N / 4, 50);
+            heap_v.Swap(other_inline);
+            assert(has_ids(heap_v, N / 4, 50) && has_ids(other_inline, N / 2, 0));
+        }
+        assert(ThrowingMoveObj::num_alive == 0);
+    }
+}
+
+void Test12() {
+    const size_t SIZE = 10;
+    const size_t COUNT = 4;
+    {
+        const std::vector<int> src{1, 2, 3, 4, 5};
+        Vector<int> v(src.begin(), src.end());
+        assert(v.Size() == src.size());
+        assert(v.Capacity() == src.size());
+        assert(std::equal(v.begin(), v.end(), src.begin(), src.end()));
+
+        std::istringstream input("6 7 8");
+        v.Append(std::istream_iterator<int>(input), std::istream_iterator<int>());
+        v.Insert(v.begin() + 1, 2, 0);
+        const std::list<int> middle{-1, -2};
+        v.Insert(v.begin() + 3, middle.begin(), middle.end());
+        std::istringstream front("9 9");
+        v.Insert(v.begin(), std::istream_iterator<int>(front), std::istream_iterator<int>());
+        assert((std::vector<int>(v.begin(), v.end()) == std::vector<int>{9, 9, 1, 0, 0, -1, -2, 2, 3, 4, 5, 6, 7, 8}));
+
+        // Вставка собственного диапазона и собственного элемента
+        v.Reserve(v.Size() * 4);
+        v.Insert(v.begin(), v.begin() + 2, v.begin() + 5);
+        v.Insert(v.begin() + 1, 3, v[0]);
+        assert((std::vector<int>(v.begin(), v.begin() + 8) == std::vector<int>{1, 1, 1, 1, 0, 0, 9, 9}));
+        v.Insert(v.end(), v.begin(), v.end());
+        assert(v.Size() == 40);
+        assert(v[20] == 1 && v[39] == 8);
+    }
+    {
+        using Alloc = TrackingAllocator<Obj, false>;
+        Obj::ResetCounters();
+        Alloc::ResetCounters();
+        Vector<Obj, Alloc> src(COUNT, Alloc{1});
+        for (size_t i = 0; i < COUNT; ++i) {
+            src[i].id = static_cast<int>(i + 1);
+        }
+        Vector<Obj, Alloc> v(SIZE, Alloc{1});
+        Alloc::ResetCounters();
+        auto pos = v.Insert(v.begin() + 2, src.begin(), src.end());
+        assert(Alloc::num_allocations == 1);
+        assert(pos == v.begin() + 2);
+        assert(v.Size() == SIZE + COUNT);
+        assert(v[2].id == 1);
+        assert(v[5].id == 4);
+        assert(v[6].id == 0);
+        assert(Obj::num_copied == static_cast<int>(COUNT));
+        assert(Obj::num_moved == static_cast<int>(SIZE));
+
+        v.Reserve(v.Size() + COUNT * 2);
+        const int old_copied_or_assigned = Obj::num_copied + Obj::num_assigned;
+        Alloc::ResetCounters();
+        // Вставляется меньше элементов, чем в хвосте, и больше
+        v.Insert(v.end() - 1, src.begin(), src.end());
+        v.Insert(v.end() - 2, COUNT, src[0]);
+        assert(Alloc::num_allocations == 0);
+        assert(v.Size() == SIZE + COUNT * 3);
+        std::vector<int> tail_ids;
+        std::transform(v.end() - 10, v.end(), std::back_inserter(tail_ids), [](const Obj& obj) {
+            return obj.id;
+        });
+        assert((tail_ids == std::vector<int>{0, 1, 2, 3, 1, 1, 1, 1, 4, 0}));
+        assert(Obj::num_copied + Obj::num_assigned == old_copied_or_assigned + static_cast<int>(COUNT * 2));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Vector<Obj> src(COUNT);
+        src[COUNT - 1].throw_on_copy = true;
+        Vector<Obj> v(SIZE);
+        v[0].id = 1;
+        try {
+            v.Insert(v.begin(), src.begin(), src.end());
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        assert(v[0].id == 1);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE + COUNT));
+    }
+}
+
+void Test13() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE, DEFAULT_INIT);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        assert(v.Capacity() == SIZE * 2);
+        assert(Obj::num_default_constructed == static_cast<int>(SIZE * 2));
+        v.ResizeDefaultInit(SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE / 2));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<char> v(SIZE, DEFAULT_INIT);
+        assert(v.Size() == SIZE);
+        std::fill(v.begin(), v.end(), 'a');
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        assert(v[SIZE - 1] == 'a');
+    }
+    {
+        const std::string text = "Hello, world";
+        Vector<char> v;
+        v.PushBack('>');
+        v.ResizeAndOverwrite(SIZE, [&text](char* data, size_t count) {
+            assert(count == SIZE);
+            assert(data[0] == '>');
+            return static_cast<size_t>(std::copy(text.begin(), text.end(), data + 1) - data);
+        });
+        assert(v.Size() == text.size() + 1);
+        assert(v.Capacity() == SIZE);
+        assert(std::string(v.begin(), v.end()) == ">" + text);
+
+        v.ResizeAndOverwrite(5, [](char* /*data*/, size_t count) {
+            return count - 1;
+        });
+        assert(v.Size() == 4);
+        assert(v.Capacity() == SIZE);
+        assert(std::string(v.begin(), v.end()) == ">Hel");
+    }
+}
+
+void Test14() {
+    const size_t SIZE = 10;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        auto pos = v.Erase(v.begin() + 2, v.begin() + 5);
+        assert(pos == v.begin() + 2);
+        assert(v.Size() == SIZE - 3);
+        assert(v.Capacity() == SIZE);
+        assert(v[2].id == 5);
+        assert(v[SIZE - 4].id == static_cast<int>(SIZE - 1));
+        assert(Obj::num_move_assigned == static_cast<int>(SIZE - 5));
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 3));
+        assert(v.Erase(v.begin() + 1, v.begin() + 1) == v.begin() + 1);
+        assert(v.Size() == SIZE - 3);
+
+        const int old_move_assigned = Obj::num_move_assigned;
+        pos = v.SwapErase(v.begin() + 1);
+        assert(pos->id == static_cast<int>(SIZE - 1));
+        assert(v.Size() == SIZE - 4);
+        assert(Obj::num_move_assigned == old_move_assigned + 1);
+        pos = v.SwapErase(v.end() - 1);
+        assert(pos == v.end());
+        assert(Obj::num_move_assigned == old_move_assigned + 1);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 5));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int> v;
+        for (int i = 0; i < 100; ++i) {
+            v.PushBack(i);
+        }
+        const size_t erased = EraseIf(v, [](int x) {
+            return x % 3 != 0;
+        });
+        assert(erased == 66);
+        assert(v.Size() == 34);
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i] == static_cast<int>(i * 3));
+        }
+        assert(EraseIf(v, [](int) {
+                   return false;
+               }) == 0);
+        v.Erase(v.begin(), v.end());
+        assert(v.Size() == 0);
+    }
+}
+
+void Test15() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Resize(SIZE / 2);
+        assert(v.Capacity() == SIZE);
+        v.ShrinkToFit();
+        assert(v.Capacity() == SIZE / 2);
+        assert(v.Size() == SIZE / 2);
+        assert(Obj::num_moved == static_cast<int>(SIZE / 2));
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == 0);
+        v.Resize(SIZE / 4);
+        v.ClearAndFree();
+        assert(v.Capacity() == 0);
+        assert(v.begin() == nullptr);
+        assert(Obj::GetAliveObjectCount() == 0);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+    }
+    {
+        Vector<int, std::allocator<int>, AutoShrinkGrowth<>> v(SIZE);
+        v.Resize(SIZE / 4);
+        assert(v.Capacity() == SIZE);
+        v.PopBack();
+        // Размер упал ниже четверти емкости
+        assert(v.Capacity() == (SIZE / 4 - 1) * 2);
+        const size_t capacity = v.Capacity();
+        for (int i = 0; i < 10; ++i) {
+            v.PushBack(i);
+            v.PopBack();
+        }
+        assert(v.Capacity() == capacity);
+
+        v.Erase(v.begin() + 2, v.end());
+        assert(v.Capacity() == 4);
+        v.Erase(v.begin());
+        assert(v.Capacity() == 4);
+        v.SwapErase(v.begin());
+        assert(v.Capacity() == 0);
+    }
+}
+
+void Test16() {
+    const size_t SIZE = 10;
+    static LateStatsUser late_user;
+    static_assert(noexcept(VectorStats<>::Counters()));
+    {
+        static_assert(sizeof(Vector<int>) == sizeof(Vector<int, std::allocator<int>, DoublingGrowth, VectorStats<>>));
+        using Stats = VectorStats<ObjStatsTag>;
+        Stats::Counters().Reset();
+        {
+            Vector<Obj, std::allocator<Obj>, DoublingGrowth, Stats> v(SIZE);
+            v.PushBack(Obj{1});
+            v.Reserve(SIZE * 4);
+            v.Resize(SIZE * 5);
+            const auto v_copy(v);
+        }
+        const VectorStatsCounters& c = Stats::Counters();
+        assert(c.allocations == 5);
+        assert(c.reallocations == 3);
+        assert(c.bytes_allocated == (SIZE + SIZE * 2 + SIZE * 4 + SIZE * 8 + SIZE * 5) * sizeof(Obj));
+        assert(c.elements_moved == SIZE + (SIZE + 1) * 2);
+        assert(c.elements_copied == 0);
+        assert(c.peak_capacity_bytes == SIZE * 8 * sizeof(Obj));
+        assert(c.wasted_capacity_bytes == SIZE * 3 * sizeof(Obj));
+        assert(c.destroyed == 2);
+    }
+    {
+        using Stats = VectorStats<FallbackStatsTag>;
+        Stats::Counters().Reset();
+        {
+            Vector<ThrowingMoveObj, std::allocator<ThrowingMoveObj>, DoublingGrowth, Stats> v(SIZE);
+            v.Reserve(SIZE * 2);
+            Vector<int, MallocAllocator<int>, DoublingGrowth, Stats> ints;
+            ints.Resize(SIZE);
+            ints.PushBack(1);
+            ints.Insert(ints.begin(), SIZE * 2, 2);
+        }
+        const VectorStatsCounters& c = Stats::Counters();
+        assert(c.elements_copied == SIZE);
+        assert(c.in_place_reallocations == 1);
+        assert(c.elements_relocated_bitwise == SIZE + 1);
+
+        std::ostringstream out;
+        VectorStatsRegistry::Instance().Dump(out);
+        const std::string dump = out.str();
+        assert(dump.find("test objects: allocations=5 reallocations=3") != std::string::npos);
+        assert(dump.find("copy fallback: ") != std::string::npos);
+        assert(dump.find(" copied=10 ") != std::string::npos);
+    }
+}
+
+void Test17() {
+    using CV = ConcurrentVector<int>;
+    assert(CV::SegmentOf(0) == 0);
+    assert(CV::SegmentOf(CV::FIRST_SEGMENT_SIZE - 1) == 0);
+    assert(CV::SegmentOf(CV::FIRST_SEGMENT_SIZE) == 1);
+    assert(CV::SegmentOf(CV::FIRST_SEGMENT_SIZE * 3 - 1) == 1);
+    assert(CV::SegmentOf(CV::FIRST_SEGMENT_SIZE * 3) == 2);
+    assert(CV::SegmentBegin(2) == CV::FIRST_SEGMENT_SIZE * 3);
+    {
+        const int NUM_THREADS = 8;
+        const int PER_THREAD = 20'000;
+        CV v;
+        v.PushBack(-1);
+        const int* first = &v[0];
+        std::vector<std::thread> threads;
+        for (int t = 0; t < NUM_THREADS; ++t) {
+            threads.emplace_back([&v, t] {
+                for (int i = 0; i < PER_THREAD; ++i) {
+                    const size_t index = v.EmplaceBack(t * PER_THREAD + i);
+                    assert(v[index] == t * PER_THREAD + i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // Элементы не переносились
+        assert(first == &v[0]);
+        assert(v.Size() == NUM_THREADS * PER_THREAD + 1);
+        std::vector<int> values;
+        v.ForEach([&values](int value) {
+            values.push_back(value);
+        });
+        std::sort(values.begin(), values.end());
+        for (int i = 0; i <= NUM_THREADS * PER_THREAD; ++i) {
+            assert(values[i] == i - 1);
+        }
+        assert(v.TryGet(v.Size()) == nullptr);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            ConcurrentVector<Obj> v;
+            v.Reserve(1000);
+            for (int i = 0; i < 100; ++i) {
+                v.EmplaceBack(i);
+            }
+            Obj::default_construction_throw_countdown = 1;
+            try {
+                v.EmplaceBack();
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 101);
+            assert(!v.IsPublished(100));
+            assert(v.IsPublished(99));
+            assert(v[99].id == 99);
+            assert(Obj::GetAliveObjectCount() == 100);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test18() {
+    {
+        const size_t NUM_THREADS = 8;
+        const int PER_THREAD = 100'000;
+        ParallelCollector<int> collector(NUM_THREADS);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < NUM_THREADS; ++t) {
+            threads.emplace_back([&collector, t] {
+                Vector<int>& local = collector.Local(t);
+                for (int i = 0; i < PER_THREAD; ++i) {
+                    local.PushBack(static_cast<int>(t) * PER_THREAD + i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(collector.Size() == NUM_THREADS * PER_THREAD);
+        Vector<int> result = collector.Collect();
+        // Память выделена один раз под точный размер, порядок буферов сохранен
+        assert(result.Size() == NUM_THREADS * PER_THREAD);
+        assert(result.Capacity() == result.Size());
+        for (size_t i = 0; i < result.Size(); ++i) {
+            assert(result[i] == static_cast<int>(i));
+        }
+        assert(collector.Size() == 0);
+        assert(collector.Local(0).Capacity() >= PER_THREAD);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(2);
+        Vector<Obj> parts[3];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 5; ++j) {
+                parts[i].EmplaceBack(i * 5 + j);
+            }
+        }
+        v.ParallelAppend(std::begin(parts), std::end(parts));
+        assert(v.Size() == 17);
+        assert(v[2].id == 0 && v[16].id == 14);
+        assert(parts[1].Size() == 0);
+        assert(Obj::GetAliveObjectCount() == 17);
+    }
+    {
+        // Частей намного больше, чем ядер, и объем выше порога параллельной обработки
+        const size_t PARTS = 1000;
+        const size_t PER_PART = 1000;
+        Vector<Vector<int>> parts(PARTS);
+        for (size_t i = 0; i < PARTS; ++i) {
+            parts[i].Resize(PER_PART);
+            std::iota(parts[i].begin(), parts[i].end(), static_cast<int>(i * PER_PART));
+        }
+        Vector<int> v;
+        v.ParallelAppend(parts.begin(), parts.end());
+        assert(v.Size() == PARTS * PER_PART);
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+        assert(std::all_of(parts.begin(), parts.end(), [](const Vector<int>& part) { return part.Size() == 0; }));
+    }
+    {
+        ThrowingMoveObj::num_alive = 0;
+        {
+            Vector<ThrowingMoveObj> v;
+            v.EmplaceBack(-1);
+            Vector<ThrowingMoveObj> parts[3];
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    parts[i].EmplaceBack(i * 4 + j);
+                }
+            }
+            ThrowingMoveObj::copy_throw_countdown = 7;
+            try {
+                v.ParallelAppend(std::begin(parts), std::end(parts));
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            ThrowingMoveObj::copy_throw_countdown = 0;
+            assert(v.Size() == 1);
+            for (int i = 0; i < 3; ++i) {
+                assert(parts[i].Size() == 4);
+                assert(parts[i][3].id == i * 4 + 3);
+            }
+            assert(ThrowingMoveObj::num_alive == 13);
+        }
+        assert(ThrowingMoveObj::num_alive == 0);
+    }
+}
+
+void Test19() {
+    const size_t SIZE = 1'000'000;
+    const ParallelPolicy FOUR_THREADS{4};
+    {
+        Vector<int> v(SIZE, PARALLEL);
+        assert(std::all_of(v.begin(), v.end(), [](int value) { return value == 0; }));
+        std::iota(v.begin(), v.end(), 0);
+        v.Reserve(SIZE * 2, FOUR_THREADS);
+        assert(v.Capacity() == SIZE * 2);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+    }
+    ParallelObj::num_alive = 0;
+    {
+        ParallelObj::default_construction_throw_countdown = SIZE - 10;
+        try {
+            Vector<ParallelObj> v(SIZE, FOUR_THREADS);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        ParallelObj::default_construction_throw_countdown = 0;
+        assert(ParallelObj::num_alive == 0);
+    }
+    {
+        Vector<ParallelObj> v(SIZE, FOUR_THREADS);
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        {
+            Vector<ParallelObj> copy(v, FOUR_THREADS);
+            assert(copy.Size() == SIZE);
+            assert(copy[0].id == 0 && copy[SIZE - 1].id == static_cast<int>(SIZE - 1));
+            assert(ParallelObj::num_alive == static_cast<int>(SIZE * 2));
+
+            Vector<ParallelObj> shorter(SIZE / 2, FOUR_THREADS);
+            shorter.Reserve(SIZE);
+            shorter.CopyNotSwap(v, FOUR_THREADS);
+            assert(shorter.Size() == SIZE && shorter[SIZE - 1].id == static_cast<int>(SIZE - 1));
+            copy.Resize(SIZE / 3);
+            shorter.CopyNotSwap(copy, FOUR_THREADS);
+            assert(shorter.Size() == SIZE / 3 && shorter[SIZE / 3 - 1].id == static_cast<int>(SIZE / 3 - 1));
+        }
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+
+        // Сбой в последнем куске откатывает уже скопированные куски
+        v[SIZE - 10].throw_on_copy = true;
+        try {
+            Vector<ParallelObj> copy(v, FOUR_THREADS);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+        const ParallelObj* data = &v[0];
+        try {
+            v.Reserve(SIZE * 2, FOUR_THREADS);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(&v[0] == data && v.Capacity() == SIZE);
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+        v[SIZE - 10].throw_on_copy = false;
+        v.Reserve(SIZE * 2, FOUR_THREADS);
+        assert(v.Capacity() == SIZE * 2 && v[SIZE - 1].id == static_cast<int>(SIZE - 1));
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+
+        v.ClearAndFree(FOUR_THREADS);
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        assert(ParallelObj::num_alive == 0);
+    }
+}
+
+void Test20() {
+    MmapOptions options;
+    options.min_mmap_bytes = 64 << 10;
+    options.prefault_threads = 4;
+    options.numa = MmapOptions::Numa::INTERLEAVE;
+    options.node_mask = 1;
+    for (const auto pages : {MmapOptions::Pages::NORMAL, MmapOptions::Pages::TRANSPARENT_HUGE,
+                             MmapOptions::Pages::EXPLICIT_HUGE}) {
+        options.pages = pages;
+        using Alloc = MmapAllocator<int>;
+        Vector<int, Alloc> v{Alloc(options)};
+        // Рост проходит через operator new, затем через mmap и mremap
+        const int SIZE = 3'000'000;
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
+        }
+        for (int i = 0; i < SIZE; ++i) {
+            assert(v[i] == i);
+        }
+        if (pages != MmapOptions::Pages::NORMAL) {
+            assert(reinterpret_cast<uintptr_t>(&v[0]) % Alloc::HUGE_PAGE_SIZE == 0);
+        }
+        Vector<int, Alloc> copy = v;
+        assert(copy.GetAllocator() == v.GetAllocator());
+        assert(copy[SIZE - 1] == SIZE - 1);
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 10 && v[9] == 9);
+    }
+    {
+        // Нетривиальные типы растут обычным переносом
+        Vector<std::string, MmapAllocator<std::string>> v{MmapAllocator<std::string>(options)};
+        for (int i = 0; i < 100'000; ++i) {
+            v.EmplaceBack(std::to_string(i));
+        }
+        assert(v[99'999] == "99999");
+    }
+}
+
+void Test21() {
+    static_assert(Vector<int>::ALIGNMENT == alignof(int));
+    static_assert(Vector<float, AlignedAllocator<float, 64>>::ALIGNMENT == 64);
+    {
+        Vector<float, AlignedAllocator<float, 64>> v;
+        for (int i = 0; i < 10'000; ++i) {
+            v.PushBack(static_cast<float>(i));
+            // Выравнивание сохраняется при каждой реаллокации
+            assert(reinterpret_cast<uintptr_t>(v.Data()) % 64 == 0);
+        }
+        v.ShrinkToFit();
+        assert(reinterpret_cast<uintptr_t>(v.Data()) % 64 == 0);
+        float sum = 0;
+        for (float value : v) {
+            sum += value;
+        }
+        assert(sum == std::accumulate(v.begin(), v.end(), 0.0f));
+    }
+    {
+        struct alignas(128) Wide {
+            int value = 0;
+        };
+        using Alloc = AlignedAllocator<Wide, 64>;
+        static_assert(Alloc::ALIGNMENT == 128);
+        Vector<Wide, Alloc> v(3);
+        v.Reserve(100);
+        assert(reinterpret_cast<uintptr_t>(v.Data()) % 128 == 0);
+    }
+    {
+        Vector<std::string, AlignedAllocator<std::string, 32>> v;
+        v.EmplaceBack("a");
+        Vector<std::string, AlignedAllocator<std::string, 32>> copy = v;
+        assert(copy[0] == "a");
+        assert(reinterpret_cast<uintptr_t>(copy.Data()) % 32 == 0);
+    }
+}
+
+void Test22() {
+    struct Point {
+        int x;
+        double y;
+    };
+    const std::string path = "/tmp/advanced_vector_test22_" + std::to_string(getpid()) + ".bin";
+    unlink(path.c_str());
+    const int SIZE = 100'000;
+    {
+        MappedVector<Point> v(path);
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(Point{i, i * 0.5});
+        }
+        // Аргумент ссылается на элемент, который переедет при росте
+        while (v.Size() != v.Capacity()) {
+            v.PushBack(v[0]);
+        }
+        v.PushBack(v[1]);
+        assert(v[v.Size() - 1].x == 1);
+        v.Resize(SIZE);
+        v.Insert(v.begin(), Point{-1, -0.5});
+        v.Erase(v.begin() + 1);
+        v.Flush();
+    }
+    {
+        // Повторное открытие видит те же данные без разбора
+        MappedVector<Point> v(path);
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() >= SIZE);
+        assert(v[0].x == -1 && v[1].x == 1 && v[SIZE - 1].x == SIZE - 1 && v[SIZE - 1].y == (SIZE - 1) * 0.5);
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 10);
+        MappedVector<Point> moved(std::move(v));
+        assert(moved.Size() == 10 && v.Size() == 0);
+    }
+    {
+        MappedVector<Point> v(path);
+        assert(v.Size() == 10 && v.Capacity() == 10);
+        int sum = 0;
+        for (const Point& p : v) {
+            sum += p.x;
+        }
+        assert(sum == -1 + 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9);
+    }
+    try {
+        MappedVector<int> wrong_type(path);
+        assert(false && "Exception is expected");
+    } catch (const std::runtime_error&) {
+    }
+    try {
+        MappedVector<int> missing_dir("/nonexistent/dir/file.bin");
+        assert(false && "Exception is expected");
+    } catch (const std::system_error& e) {
+        assert(e.code() == std::errc::no_such_file_or_directory);
+    }
+    unlink(path.c_str());
+}
+
+void Test23() {
+    struct Point {
+        int x;
+        double y;
+    };
+    Vector<int> ints;
+    for (int i = 0; i < 100'000; ++i) {
+        ints.PushBack(i);
+    }
+    Vector<Point> points;
+    points.PushBack(Point{1, 1.5});
+    points.PushBack(Point{2, 2.5});
+    Vector<std::string> strings;
+    strings.PushBack("");
+    strings.PushBack("short");
+    // Запись длиннее буфера
+    strings.PushBack(std::string(1000, 'x'));
+    for (int i = 0; i < 1000; ++i) {
+        strings.PushBack(std::to_string(i));
+    }
+    {
+        // Несколько векторов подряд в одном потоке
+        FILE* file = std::tmpfile();
+        const int fd = fileno(file);
+        Serialize(fd, ints);
+        Serialize(fd, strings, 64);
+        Serialize(fd, points);
+        Serialize(fd, Vector<std::string>());
+        lseek(fd, 0, SEEK_SET);
+        const auto ints_copy = Deserialize<Vector<int>>(fd);
+        assert(ints_copy.Size() == ints.Size() && ints_copy.Capacity() == ints.Size());
+        assert(std::equal(ints.begin(), ints.end(), ints_copy.begin()));
+        const auto strings_copy = Deserialize<Vector<std::string>>(fd, 64);
+        assert(std::equal(strings.begin(), strings.end(), strings_copy.begin(), strings_copy.end()));
+        const auto points_copy = Deserialize<Vector<Point>>(fd);
+        assert(points_copy.Size() == 2 && points_copy[1].x == 2 && points_copy[1].y == 2.5);
+        assert(Deserialize<Vector<std::string>>(fd).Size() == 0);
+        try {
+            Deserialize<Vector<int>>(fd);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        std::fclose(file);
+    }
+    {
+        // Самосогласованный, но испорченный заголовок: размер канала неизвестен, и память не
+        // выделяется под все заявленные элементы сразу
+        for (const bool bitwise : {true, false}) {
+            int fds[2];
+            assert(pipe(fds) == 0);
+            VectorIoHeader header;
+            header.element_size = bitwise ? sizeof(int) : 0;
+            header.size = uint64_t{1} << 40;
+            header.bytes = header.size * (bitwise ? sizeof(int) : sizeof(uint64_t));
+            const char data[16] = {};
+            detail::WriteAll(fds[1], reinterpret_cast<const char*>(&header), sizeof(header));
+            detail::WriteAll(fds[1], data, sizeof(data));
+            close(fds[1]);
+            try {
+                if (bitwise) {
+                    Deserialize<Vector<int>>(fds[0]);
+                } else {
+                    Deserialize<Vector<std::string>>(fds[0]);
+                }
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            close(fds[0]);
+        }
+        {
+            // Одна запись с огромной заявленной длиной: буфер растет только вместе с пришедшими байтами
+            int fds[2];
+            assert(pipe(fds) == 0);
+            VectorIoHeader header;
+            header.size = 1;
+            const uint64_t record_size = uint64_t{1} << 44;
+            header.bytes = sizeof(uint64_t) + record_size;
+            const char data[16] = {};
+            detail::WriteAll(fds[1], reinterpret_cast<const char*>(&header), sizeof(header));
+            detail::WriteAll(fds[1], reinterpret_cast<const char*>(&record_size), sizeof(record_size));
+            detail::WriteAll(fds[1], data, sizeof(data));
+            close(fds[1]);
+            try {
+                Deserialize<Vector<std::string>>(fds[0]);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            close(fds[0]);
+        }
+    }
+    {
+        std::vector<char> buffer(SerializedSize(strings));
+        assert(Serialize(strings, buffer.data(), buffer.size()) == buffer.size());
+        const auto copy = Deserialize<Vector<std::string>>(buffer.data(), buffer.size());
+        assert(std::equal(strings.begin(), strings.end(), copy.begin(), copy.end()));
+        try {
+            Deserialize<Vector<std::string>>(buffer.data(), buffer.size() - 1);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        try {
+            Serialize(strings, buffer.data(), buffer.size() - 1);
+            assert(false && "Exception is expected");
+        } catch (const std::length_error&) {
+        }
+    }
+    {
+        VectorIoHeader header;
+        iovec iov[2];
+        SerializeIovec(ints, header, iov);
+        std::vector<char> buffer;
+        for (const iovec& part : iov) {
+            const char* data = static_cast<const char*>(part.iov_base);
+            buffer.insert(buffer.end(), data, data + part.iov_len);
+        }
+        assert(buffer.size() == SerializedSize(ints));
+        const auto copy = Deserialize<Vector<int>>(buffer.data(), buffer.size());
+        assert(std::equal(ints.begin(), ints.end(), copy.begin(), copy.end()));
+        try {
+            Deserialize<Vector<Point>>(buffer.data(), buffer.size());
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+    }
+}
+
+void Test24() {
+    {
+        // Буфер из malloc, например полученный от C-библиотеки, переходит к вектору без копирования
+        int* buffer = static_cast<int*>(std::malloc(10 * sizeof(int)));
+        std::iota(buffer, buffer + 5, 0);
+        Vector<int, MallocAllocator<int>> v;
+        v.PushBack(42);
+        v.Adopt(buffer, 5, 10);
+        assert(v.data() == buffer && v.Size() == 5 && v.Capacity() == 10);
+        for (int i = 5; i < 10; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.data() == buffer);
+        v.PushBack(10);
+        assert(v.Size() == 11 && v[10] == 10 && v[4] == 4);
+        const VectorBuffer<int> released = v.Release();
+        assert(v.Size() == 0 && v.Capacity() == 0 && v.data() == nullptr);
+        assert(released.size == 11 && released.capacity >= 11 && released.data[10] == 10);
+        std::free(released.data);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        v.EmplaceBack(1);
+        v.EmplaceBack(2);
+        const VectorBuffer<Obj> released = v.Release();
+        assert(Obj::GetAliveObjectCount() == 2);
+        Vector<Obj> w(3);
+        w.Adopt(released.data, released.size, released.capacity);
+        assert(Obj::GetAliveObjectCount() == 2);
+        assert(w.Size() == 2 && w[1].id == 2 && &w[0] == released.data);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        RawMemory<int> memory(4);
+        int* buffer = memory.Release();
+        assert(memory.GetAddress() == nullptr && memory.Capacity() == 0);
+        RawMemory<int> adopted = RawMemory<int>::Adopt(buffer, 4);
+        assert(adopted.GetAddress() == buffer && adopted.Capacity() == 4);
+    }
+    {
+        int num_deleted = 0;
+        const auto deleter = [](void* context, void* p) {
+            ++*static_cast<int*>(context);
+            std::free(p);
+        };
+        int* buffer = static_cast<int*>(std::malloc(4 * sizeof(int)));
+        std::iota(buffer, buffer + 3, 0);
+        using Alloc = DeleterAllocator<int>;
+        {
+            Vector<int, Alloc> v;
+            v.Adopt(buffer, 3, 4, Alloc(buffer, deleter, &num_deleted));
+            v.PushBack(3);
+            assert(num_deleted == 0);
+            // Принятый буфер освобождается своей функцией при первой реаллокации
+            v.PushBack(4);
+            assert(num_deleted == 1);
+            for (int i = 0; i < 5; ++i) {
+                assert(v[i] == i);
+            }
+            Vector<int, Alloc> copy = v;
+            v.Reserve(100);
+            assert(copy.GetAllocator() == v.GetAllocator());
+        }
+        assert(num_deleted == 1);
+    }
+}
+
+// Тривиально копируемый тип, который можно только перемещать
+struct MoveOnlyPod {
+    explicit MoveOnlyPod(int value)
+        : value(value) {}
+    MoveOnlyPod(const MoveOnlyPod&) = delete;
+    MoveOnlyPod(MoveOnlyPod&&) = default;
+    MoveOnlyPod& operator=(const MoveOnlyPod&) = delete;
+    MoveOnlyPod& operator=(MoveOnlyPod&&) = default;
+
+    int value;
+};
+
+void Test25() {
+    static_assert(std::is_trivially_copyable_v<MoveOnlyPod>);
+    {
+        // Вставка с сохранением порядка сравнивается с std::vector
+        Vector<uint64_t> v;
+        std::vector<uint64_t> expected;
+        uint64_t x = 12345;
+        for (int i = 0; i < 2000; ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            const uint64_t value = x >> 40;
+            v.Insert(std::lower_bound(v.begin(), v.end(), value), value);
+            expected.insert(std::lower_bound(expected.begin(), expected.end(), value), value);
+        }
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+        for (int i = 0; i < 500; ++i) {
+            const size_t pos = (i * 7919) % v.Size();
+            v.Erase(v.begin() + pos);
+            expected.erase(expected.begin() + pos);
+        }
+        v.Erase(v.begin() + 10, v.begin() + 100);
+        expected.erase(expected.begin() + 10, expected.begin() + 100);
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+    }
+    {
+        // Аргумент ссылается на элемент сдвигаемого хвоста и на элемент перед позицией вставки
+        Vector<int> v;
+        v.Reserve(10);
+        for (int i = 0; i < 5; ++i) {
+            v.PushBack(i);
+        }
+        v.Insert(v.begin() + 1, v[3]);
+        v.Insert(v.begin() + 3, v[0]);
+        v.Emplace(v.begin(), v[v.Size() - 1]);
+        const std::vector<int> expected = {4, 0, 3, 1, 0, 2, 3, 4};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+        assert(v.Capacity() == 10);
+    }
+    {
+        SmallVector<int, 8> v;
+        for (int i = 0; i < 6; ++i) {
+            v.PushBack(i);
+        }
+        v.Insert(v.begin() + 2, v[4]);
+        v.Erase(v.begin());
+        const std::vector<int> expected = {1, 4, 2, 3, 4, 5};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+    }
+    {
+        Vector<MoveOnlyPod> v;
+        v.Reserve(8);
+        for (int i = 0; i < 4; ++i) {
+            v.EmplaceBack(i);
+        }
+        v.Emplace(v.begin() + 1, 10);
+        v.Insert(v.begin(), MoveOnlyPod(20));
+        v.Erase(v.begin() + 2);
+        const std::vector<int> expected = {20, 0, 1, 2, 3};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end(), [](const MoveOnlyPod& item, int value) {
+            return item.value == value;
+        }));
+    }
+    {
+        const std::string path = "/tmp/advanced_vector_test25_" + std::to_string(getpid()) + ".bin";
+        unlink(path.c_str());
+        {
+            MappedVector<MoveOnlyPod> v(path);
+            // Первая вставка и вставка в заполненный вектор создают временный элемент перед ростом
+            v.EmplaceBack(0);
+            while (v.Size() != v.Capacity()) {
+                v.EmplaceBack(static_cast<int>(v.Size()));
+            }
+            const size_t size = v.Size();
+            v.EmplaceBack(static_cast<int>(size));
+            v.Emplace(v.begin(), -1);
+            assert(v.Size() == size + 2);
+            assert(v[0].value == -1 && v[1].value == 0 && v[size + 1].value == static_cast<int>(size));
+        }
+        unlink(path.c_str());
+    }
+}
+
+void Test26() {
+    static_assert(StableVector<int>::CHUNK_SIZE == 16384);
+    static_assert(std::is_same_v<std::iterator_traits<StableVector<int>::iterator>::iterator_category,
+                                 std::random_access_iterator_tag>);
+    {
+        StableVector<int, 8> v;
+        v.PushBack(0);
+        const int* first = &v[0];
+        for (int i = 1; i < 100; ++i) {
+            v.EmplaceBack(i);
+        }
+        // Элементы не переносились
+        assert(first == &v[0]);
+        assert(v.Size() == 100 && v.Capacity() == 104);
+        for (int i = 0; i < 100; ++i) {
+            assert(v[i] == i);
+        }
+        assert(std::accumulate(v.begin(), v.end(), 0) == 4950);
+        assert(*std::lower_bound(v.cbegin(), v.cend(), 42) == 42);
+        assert(v.end() - v.begin() == 100);
+        size_t segments = 0;
+        int sum = 0;
+        v.ForEachSegment([&](const int* data, size_t count) {
+            ++segments;
+            sum += std::accumulate(data, data + count, 0);
+        });
+        assert(segments == 13 && sum == 4950);
+        v.Resize(20);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 24 && &v[0] == first);
+        StableVector<int, 8> copy = v;
+        assert(copy.Size() == 20 && copy[19] == 19);
+        StableVector<int, 8> moved = std::move(v);
+        assert(moved.Size() == 20 && &moved[0] == first && v.Size() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            StableVector<Obj, 4> v;
+            v.Reserve(10);
+            for (int i = 0; i < 10; ++i) {
+                v.EmplaceBack(i);
+            }
+            Obj::default_construction_throw_countdown = 3;
+            try {
+                v.Resize(20);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 12 && v[11].id == 0 && v[9].id == 9);
+            assert(Obj::num_moved == 0 && Obj::num_copied == 0);
+            v.PopBack();
+            assert(Obj::GetAliveObjectCount() == 11);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        // Исключение в конструкторе не оставляет созданных элементов
+        Obj::default_construction_throw_countdown = 3;
+        try {
+            StableVector<Obj, 4> v(10);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        StableVector<Obj, 4> v(10);
+        v[5].throw_on_copy = true;
+        try {
+            StableVector<Obj, 4> copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 10);
+    }
+}
+
+void Test27() {
+    static_assert(std::is_same_v<std::iterator_traits<IncrementalVector<int>::iterator>::iterator_category,
+                                 std::random_access_iterator_tag>);
+    {
+        Obj::ResetCounters();
+        {
+            IncrementalVector<Obj> v;
+            int max_moved = 0;
+            for (int i = 0; i < 1000; ++i) {
+                const int moved = Obj::num_moved;
+                v.EmplaceBack(i);
+                // Каждое добавление переносит не больше одного элемента
+                max_moved = std::max(max_moved, Obj::num_moved - moved);
+                assert(v[i].id == i && v[0].id == 0 && v[i / 2].id == i / 2);
+            }
+            assert(max_moved == 1 && Obj::num_copied == 0);
+            assert(v.Size() == 1000 && v.Capacity() == 1024 && v.IsMigrating());
+            int sum = 0;
+            for (const Obj& obj : v) {
+                sum += obj.id;
+            }
+            assert(sum == 499500);
+            size_t segments = 0;
+            v.ForEachSegment([&](const Obj* /*data*/, size_t count) {
+                ++segments;
+                sum -= static_cast<int>(count);
+            });
+            assert(segments == 3 && sum == 498500);
+            // Аргумент ссылается на еще не перенесенный элемент
+            v.PushBack(v[600]);
+            assert(v[1000].id == 600);
+            v.PopBack();
+            v.PopBack();
+            assert(v.Size() == 999 && v[998].id == 998);
+            const Obj* data = v.Data();
+            assert(!v.IsMigrating() && data[500].id == 500);
+            assert(Obj::GetAliveObjectCount() == 999);
+            IncrementalVector<Obj> copy = v;
+            assert(copy.Size() == 999 && copy[998].id == 998);
+            v.Clear();
+            assert(v.Size() == 0 && Obj::GetAliveObjectCount() == 999);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // При росте втрое перенос заканчивается на полпути к заполнению буфера
+        IncrementalVector<int, std::allocator<int>, GeometricGrowth<3>> v;
+        v.Reserve(4);
+        for (int i = 0; i < 100; ++i) {
+            v.PushBack(i);
+            assert(v[i] == i && v[i / 3] == i / 3);
+        }
+        assert(std::accumulate(v.begin(), v.end(), 0) == 4950);
+    }
+    {
+        // Перенос бросающего при копировании элемента не меняет вектор
+        ThrowingMoveObj::num_alive = 0;
+        {
+            IncrementalVector<ThrowingMoveObj> v;
+            for (int i = 0; i < 9; ++i) {
+                v.EmplaceBack(i);
+            }
+            assert(v.IsMigrating());
+            ThrowingMoveObj::copy_throw_countdown = 1;
+            try {
+                v.EmplaceBack(9);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 9 && ThrowingMoveObj::num_alive == 9);
+            for (int i = 0; i < 9; ++i) {
+                assert(v[i].id == i);
+            }
+            // Неудачное добавление не отодвигает окончание переноса
+            for (int i = 9; i < 16; ++i) {
+                v.EmplaceBack(i);
+            }
+            assert(!v.IsMigrating());
+            for (int i = 0; i < 16; ++i) {
+                assert(v[i].id == i);
+            }
+        }
+        assert(ThrowingMoveObj::num_alive == 0);
+    }
+    {
+        // Исключение в конструкторе не оставляет созданных элементов
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = 3;
+        try {
+            IncrementalVector<Obj> v(10);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        IncrementalVector<Obj> v(10);
+        v[5].throw_on_copy = true;
+        try {
+            IncrementalVector<Obj> copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 10);
+    }
+}
+
+void Test28() {
+    static_assert(std::is_same_v<SoAVector<int, double>::iterator::reference, std::tuple<int&, double&>>);
+    {
+        SoAVector<int, double, std::string> v;
+        for (int i = 0; i < 100; ++i) {
+            v.EmplaceBack(i, i * 0.5, std::to_string(i));
+        }
+        assert(v.Size() == 100 && v.Capacity() == 128);
+        // Столбец лежит подряд
+        ColumnSpan<int> ids = v.Column<0>();
+        assert(ids.Size() == 100 && ids.Data() + 99 == &ids[99]);
+        assert(std::accumulate(ids.begin(), ids.end(), 0) == 4950);
+        auto [id, x, name] = v[42];
+        assert(id == 42 && x == 21.0 && name == "42");
+        x = -1.0;
+        assert(v.Column<1>()[42] == -1.0);
+        v.PushBack({100, 50.0, "100"});
+        assert(std::get<2>(v[100]) == "100");
+        // Аргумент ссылается на элемент, который переедет при росте
+        v.Resize(128);
+        v.EmplaceBack(std::get<0>(v[3]), std::get<1>(v[3]), std::get<2>(v[3]));
+        assert(v.Size() == 129 && v.Capacity() == 256 && std::get<2>(v[128]) == "3");
+        v.Erase(v.begin() + 1, v.begin() + 11);
+        assert(v.Size() == 119 && std::get<0>(v[1]) == 11 && std::get<2>(v[1]) == "11");
+        v.Erase(v.cbegin());
+        assert(std::get<0>(*v.begin()) == 11);
+        int sum = 0;
+        for (auto [id, x, name] : v) {
+            sum += id;
+        }
+        assert(sum == std::accumulate(v.Column<0>().begin(), v.Column<0>().end(), 0));
+        const SoAVector<int, double, std::string> copy = v;
+        assert(copy.Size() == v.Size() && std::get<2>(copy[0]) == "11");
+        assert(copy.Column<2>()[0] == "11");
+        SoAVector<int, double, std::string> moved = std::move(v);
+        assert(moved.Size() == copy.Size() && v.Size() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            SoAVector<int, Obj> v;
+            v.Reserve(4);
+            for (int i = 0; i < 4; ++i) {
+                v.EmplaceBack(i, i);
+            }
+            // Obj перемещается без исключений, поэтому переносится без копирования
+            v.EmplaceBack(4, 4);
+            assert(Obj::num_moved == 4 && Obj::num_copied == 0);
+            Obj::default_construction_throw_countdown = 2;
+            try {
+                v.Resize(8);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 5 && Obj::GetAliveObjectCount() == 5);
+            v.PopBack();
+            assert(Obj::GetAliveObjectCount() == 4);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // Если копирование поля бросает исключение при росте, вектор не меняется
+        ThrowingMoveObj::num_alive = 0;
+        {
+            SoAVector<std::string, ThrowingMoveObj> v;
+            for (int i = 0; i < 4; ++i) {
+                v.EmplaceBack(std::to_string(i), i);
+            }
+            ThrowingMoveObj::copy_throw_countdown = 3;
+            try {
+                v.EmplaceBack("4", 4);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 4 && v.Capacity() == 4 && ThrowingMoveObj::num_alive == 4);
+            for (int i = 0; i < 4; ++i) {
+                assert(std::get<0>(v[i]) == std::to_string(i) && std::get<1>(v[i]).id == i);
+            }
+        }
+        assert(ThrowingMoveObj::num_alive == 0);
+    }
+}
+
+// Сравнивает ядра всех поддерживаемых наборов инструкций со стандартными алгоритмами
+// на диапазонах всех длин до 100, чтобы покрыть и векторную часть, и хвост
+template <typename T>
+void CheckSimdKernels(const std::vector<T>& data, T absent) {
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON}) {
+        if (!IsSupported(level)) continue;
+        for (size_t size = 0; size <= std::min<size_t>(data.size(), 100); ++size) {
+            const T* first = data.data();
+            const T* last = first + size;
+            for (size_t i = 0; i < size; i += 7) {
+                assert(detail::Find(first, last, first[i], level) == std::find(first, last, first[i]));
+                assert(detail::Count(first, last, first[i], level) == static_cast<size_t>(std::count(first, last, first[i])));
+            }
+            assert(detail::Find(first, last, absent, level) == last);
+            assert(detail::Count(first, last, absent, level) == 0);
+            if (size != 0) {
+                const auto [min, max] = std::minmax_element(first, last);
+                assert(detail::MinMax(first, last, level) == std::pair(*min, *max));
+            }
+            assert(detail::Sum(first, last, level) == std::accumulate(first, last, SumType<T>{0}));
+        }
+    }
+}
+
+void Test29() {
+    static_assert(std::is_same_v<SumType<int32_t>, int64_t> && std::is_same_v<SumType<uint32_t>, uint64_t>);
+    {
+        std::vector<int32_t> data(100);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<int32_t>((i * 7919) % 101) - 50;
+        }
+        data[37] = INT32_MIN;
+        data[91] = INT32_MAX;
+        CheckSimdKernels<int32_t>(data, 1000);
+        std::vector<uint32_t> unsigned_data(data.begin(), data.end());
+        CheckSimdKernels<uint32_t>(unsigned_data, 1000);
+        // Небольшие значения с точной суммой во float
+        std::vector<float> float_data(data.size());
+        for (size_t i = 0; i < data.size(); ++i) {
+            float_data[i] = static_cast<float>((i * 7919) % 101) * 0.25f - 12.5f;
+        }
+        CheckSimdKernels<float>(float_data, 0.1f);
+        std::vector<double> double_data(float_data.begin(), float_data.end());
+        CheckSimdKernels<double>(double_data, 0.1);
+    }
+    {
+        // Сумма не переполняется, даже если переполнился бы int32_t
+        Vector<int32_t> v(1000);
+        std::fill(v.begin(), v.end(), INT32_MAX);
+        v[999] = 7;
+        assert(Sum(v) == int64_t{INT32_MAX} * 999 + 7);
+        assert(Find(v, 7) == v.begin() + 999 && Find(v, 8) == v.end());
+        assert(Count(v, INT32_MAX) == 999 && Contains(v, 7) && !Contains(v, 8));
+        assert(MinMax(v) == std::pair(7, INT32_MAX));
+        const Vector<int32_t>& cv = v;
+        const int32_t* found = Find(cv, 7);
+        assert(found == &v[999]);
+        *Find(v, 7) = 8;
+        assert(Contains(cv.begin(), cv.end(), 8));
+    }
+    {
+        Vector<float> v;
+        v.PushBack(-0.0f);
+        v.PushBack(std::numeric_limits<float>::quiet_NaN());
+        while (v.Size() < 40) {
+            v.PushBack(1.5f);
+        }
+        assert(Find(v, 0.0f) == v.begin());
+        assert(!Contains(v, std::numeric_limits<float>::quiet_NaN()));
+        assert(Count(v, 1.5f) == 38 && Sum(v.begin() + 2, v.end()) == 57.0f);
+        SmallVector<uint32_t, 4> small;
+        small.PushBack(4000000000u);
+        small.PushBack(1);
+        assert(MinMax(small) == std::pair(1u, 4000000000u) && Sum(small) == 4000000001u);
+    }
+}
+
+void Test30() {
+    {
+        // Поиск без ветвлений совпадает с std::lower_bound на всех размерах и позициях
+        std::vector<int> data;
+        for (int size = 0; size <= 40; ++size) {
+            for (int key = -1; key <= 2 * size + 1; ++key) {
+                const int* it = detail::BranchlessLowerBound(data.data(), data.size(), key, detail::Identity{}, std::less<int>{});
+                assert(it == std::lower_bound(data.data(), data.data() + data.size(), key));
+            }
+            data.push_back(2 * size);
+        }
+    }
+    {
+        Vector<int> values;
+        for (int value : {5, 3, 9, 3, 1}) {
+            values.PushBack(value);
+        }
+        FlatSet<int> set(std::move(values));
+        assert(set.Size() == 4 && std::is_sorted(set.begin(), set.end()));
+        assert(set.Contains(3) && !set.Contains(4) && set.Count(9) == 1);
+        assert(*set.LowerBound(4) == 5 && *set.UpperBound(5) == 9 && set.UpperBound(9) == set.end());
+        assert(!set.Insert(5).second);
+        const auto [it, inserted] = set.Insert(4);
+        assert(inserted && *it == 4 && set.Size() == 5);
+        const int batch[] = {8, 2, 4, 8, 0, 10};
+        set.InsertBatch(std::begin(batch), std::end(batch));
+        const std::vector<int> expected = {0, 1, 2, 3, 4, 5, 8, 9, 10};
+        assert(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+        assert(set.Erase(8) == 1 && set.Erase(8) == 0 && set.Size() == 8);
+        set.Erase(set.begin());
+        assert(*set.begin() == 1);
+        FlatSet<int, std::greater<int>> reversed;
+        reversed.InsertBatch(expected.begin(), expected.end());
+        assert(*reversed.begin() == 10 && reversed.Contains(0) && *reversed.LowerBound(7) == 5);
+    }
+    {
+        FlatMap<std::string, int> map;
+        map["b"] = 2;
+        map["a"] = 1;
+        assert(map.Size() == 2 && map.begin()->first == "a" && map.At("b") == 2);
+        assert(!map.TryEmplace("a", 10).second && map.At("a") == 1);
+        assert(!map.InsertOrAssign("a", 10).second && map.At("a") == 10);
+        assert(map.Insert({"c", 3}).second && map.Find("c")->second == 3);
+        try {
+            map.At("z");
+            assert(false && "Exception is expected");
+        } catch (const std::out_of_range&) {
+        }
+        // Из повторов в пакете остается первый, уже имеющиеся ключи не перезаписываются
+        std::vector<std::pair<std::string, int>> batch = {{"e", 5}, {"d", 4}, {"e", 50}, {"a", 100}};
+        map.InsertBatch(batch.begin(), batch.end());
+        const std::map<std::string, int> expected = {{"a", 10}, {"b", 2}, {"c", 3}, {"d", 4}, {"e", 5}};
+        assert(map.Size() == expected.size());
+        assert(std::equal(map.begin(), map.end(), expected.begin(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first == rhs.first && lhs.second == rhs.second;
+        }));
+        map.Find("d")->second = 40;
+        assert(map.At("d") == 40);
+        const FlatMap<std::string, int>& const_map = map;
+        assert(const_map.At("e") == 5 && const_map.Find("x") == const_map.end());
+        Vector<std::pair<std::string, int>> values = map.Extract();
+        assert(values.Size() == 5 && map.Size() == 0);
+    }
+    {
+        // Сравнение, бросающее исключение при сортировке пакета, оставляет контейнер прежним
+        struct ThrowingLess {
+            bool operator()(int lhs, int rhs) const {
+                if (lhs == 13 || rhs == 13) {
+                    throw std::runtime_error("Oops");
+                }
+                return lhs < rhs;
+            }
+        };
+        FlatSet<int, ThrowingLess> set;
+        const int good[] = {3, 1, 2};
+        set.InsertBatch(std::begin(good), std::end(good));
+        const int bad[] = {7, 13, 5};
+        try {
+            set.InsertBatch(std::begin(bad), std::end(bad));
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(set.Size() == 3 && *set.begin() == 1 && set.Contains(3));
+    }
+}
+
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+
+// Нетривиальный тип, который переносится перемещением
+struct ConstexprObj {
+    constexpr explicit ConstexprObj(int value = -1)
+        : value(new int(value)) {}
+    constexpr ConstexprObj(const ConstexprObj& other)
+        : value(new int(*other.value)) {}
+    constexpr ConstexprObj(ConstexprObj&& other) noexcept
+        : value(std::exchange(other.value, nullptr)) {}
+    constexpr ~ConstexprObj() {
+        delete value;
+    }
+
+    int* value;
+};
+
+// Таблица, построенная при компиляции: вектор живет только внутри вычисления константы
+constexpr std::array<int, 10> MakeSquares() {
+    Vector<int> v;
+    for (int i = 0; i < 10; ++i) {
+        v.PushBack(i * i);
+    }
+    std::array<int, 10> table{};
+    for (size_t i = 0; i < v.Size(); ++i) {
+        table[i] = v[i];
+    }
+    return table;
+}
+
+constexpr bool CheckConstexprVector() {
+    Vector<ConstexprObj> v(3);
+    v.Reserve(4);
+    for (int i = 0; i < 10; ++i) {
+        v.EmplaceBack(i);
+    }
+    // Аргумент ссылается на элемент, который переедет при реаллокации
+    v.Resize(v.Capacity());
+    v.EmplaceBack(*v[3].value);
+    v.PopBack();
+    v.Resize(5);
+    bool ok = v.Size() == 5 && *v[0].value == -1 && *v[4].value == 1 && v.Capacity() == 32;
+    v.Clear();
+    ok = ok && v.Size() == 0;
+    Vector<ConstexprObj> moved = std::move(v);
+    moved.EmplaceBack(42);
+    return ok && *moved[0].value == 42 && *moved.begin()->value == 42;
+}
+
+#endif
+
+void Test31() {
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+    constexpr std::array<int, 10> squares = MakeSquares();
+    static_assert(squares[0] == 0 && squares[9] == 81);
+    static_assert(CheckConstexprVector());
+    // Те же функции работают и во время выполнения
+    assert(MakeSquares() == squares);
+    assert(CheckConstexprVector());
+#endif
+}
+
+void Test32() {
+    const size_t N = 8;
+    const int ID = 42;
+    using namespace std::literals;
+    static_assert(std::is_trivially_copyable_v<InplaceVector<int, N>>);
+    static_assert(!std::is_trivially_copyable_v<InplaceVector<Obj, N>>);
+    {
+        InplaceVector<int, N> v;
+        for (size_t i = 0; i < N; ++i) {
+            assert(*v.TryPushBack(static_cast<int>(i)) == static_cast<int>(i));
+        }
+        assert(v.TryEmplaceBack(ID) == nullptr);
+        try {
+            v.PushBack(ID);
+            assert(false && "Exception is expected");
+        } catch (const std::bad_alloc&) {
+        }
+        assert(v.Size() == N);
+        v.Erase(v.begin() + 1, v.begin() + 3);
+        v.Insert(v.begin(), v[N - 3]);
+        assert(v.Size() == N - 1 && v[0] == static_cast<int>(N - 1) && v[1] == 0 && v[2] == 3);
+        InplaceVector<int, N> copy = v;
+        copy[0] = ID;
+        assert(v[0] == static_cast<int>(N - 1) && copy.Size() == N - 1);
+    }
+    {
+        Obj::ResetCounters();
+        InplaceVector<Obj, N> v(N / 2);
+        v.EmplaceBack(ID, "Ivan"s);
+        v.Emplace(v.begin(), ID + 1, "Petr"s);
+        // Аргумент ссылается на элемент, который сдвинется
+        v.Insert(v.begin() + 1, v[N / 2 + 1]);
+        assert(v.Size() == N / 2 + 3);
+        assert(v[0].name == "Petr"s && v[1].id == ID && v[N / 2 + 2].id == ID);
+        v.Erase(v.begin() + 1);
+        assert(v[1].id == 0);
+
+        InplaceVector<Obj, N> copy(v);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(2 * (N / 2 + 2)));
+        InplaceVector<Obj, N> other(1);
+        other.Swap(copy);
+        assert(other.Size() == N / 2 + 2 && copy.Size() == 1 && other[0].id == ID + 1);
+        copy = other;
+        assert(copy.Size() == N / 2 + 2 && copy[N / 2 + 1].id == ID);
+        other.Resize(N);
+        try {
+            other.Emplace(other.begin(), ID);
+            assert(false && "Exception is expected");
+        } catch (const std::bad_alloc&) {
+        }
+        assert(other.Size() == N && other[0].id == ID + 1);
+        other.Clear();
+        v = std::move(copy);
+        assert(v.Size() == N / 2 + 2 && v[0].id == ID + 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        InplaceVector<Obj, N> v(N / 2);
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.Resize(N);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == N / 2);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(N / 2));
+        try {
+            v.Resize(N + 1);
+            assert(false && "Exception is expected");
+        } catch (const std::bad_alloc&) {
+        }
+        assert(v.Size() == N / 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test33() {
+    const size_t N = 100;
+    VectorPool& pool = *VectorPool::Local();
+    pool.Trim();
+    {
+        const int* data = nullptr;
+        {
+            PooledVector<int> v;
+            v.Reserve(N);
+            data = v.Data();
+        }
+        assert(pool.CachedBlocks() == 1);
+        assert(pool.CachedBytes() == 512);
+        // Буфер того же класса размера берется из пула
+        PooledVector<int> v;
+        v.Reserve(N + 10);
+        assert(v.Data() == data);
+        assert(pool.CachedBlocks() == 0);
+        // При росте прежний буфер возвращается в пул
+        v.Resize(N * 2);
+        assert(pool.CachedBlocks() == 1);
+        PooledVector<int> w(N);
+        assert(w.Data() == data);
+    }
+    {
+        pool.Trim();
+        pool.SetMaxBlocks(2);
+        {
+            PooledVector<int> a(N), b(N), c(N);
+        }
+        assert(pool.CachedBlocks() == 2);
+        // Слишком крупные буферы не кэшируются
+        {
+            PooledVector<char> big(VectorPool::MAX_BLOCK_SIZE + 1);
+        }
+        assert(pool.CachedBlocks() == 2);
+        pool.SetMaxBlocks(1);
+        assert(pool.CachedBlocks() == 1);
+        pool.Trim();
+        assert(pool.CachedBlocks() == 0 && pool.CachedBytes() == 0);
+        pool.SetMaxBlocks(VectorPool::DEFAULT_MAX_BLOCKS);
+    }
+    {
+        Obj::ResetCounters();
+        PooledVector<Obj> v(N);
+        v.EmplaceBack(42);
+        // Прежний буфер вернулся в пул при росте
+        assert(pool.CachedBlocks() == 1);
+        pool.Trim();
+        // Буфер, освобожденный в другом потоке, остается в его пуле и освобождается при выходе из потока
+        std::thread([moved = std::move(v)]() mutable {
+            assert(moved.Size() == N + 1 && moved[N].id == 42);
+            PooledVector<Obj> local(N);
+            assert(VectorPool::Local() != nullptr);
+        }).join();
+        assert(pool.CachedBlocks() == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Блок, выделенный после уничтожения пула потока, попадает в пул другого потока и
+        // переиспользуется для выделения во весь класс размера
+        struct LateAllocation {
+            ~LateAllocation() {
+                assert(VectorPool::Local() == nullptr);
+                *out = PoolAllocator<char>().allocate(1);
+            }
+
+            char** out;
+        };
+        char* block = nullptr;
+        std::thread([&block] {
+            thread_local LateAllocation late{&block};
+            (void)late;
+            assert(VectorPool::Local() != nullptr);
+        }).join();
+        assert(block != nullptr);
+        pool.Trim();
+        PoolAllocator<char>().deallocate(block, 1);
+        assert(pool.CachedBlocks() == 1);
+        char* reused = PoolAllocator<char>().allocate(VectorPool::MIN_BLOCK_SIZE);
+        assert(reused == block);
+        std::fill_n(reused, VectorPool::MIN_BLOCK_SIZE, 'x');
+        PoolAllocator<char>().deallocate(reused, VectorPool::MIN_BLOCK_SIZE);
+        pool.Trim();
+    }
+}
+
+void Test34() {
+    const size_t N = 16;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        SharedVector<Obj> table{Vector<Obj>(N)};
+        assert(!table.IsShared());
+        const SharedVector<Obj> snapshot = table.Snapshot();
+        assert(table.IsShared() && snapshot.Data() == table.Data());
+        assert(Obj::num_copied == 0 && Obj::num_moved == 0);
+
+        // Первое изменение после снимка копирует содержимое, следующие - нет
+        table.EmplaceBack(ID);
+        assert(Obj::num_copied == static_cast<int>(N));
+        assert(!table.IsShared() && !snapshot.IsShared());
+        table.Modify([](Vector<Obj>& values) {
+            values[0].id = ID;
+        });
+        assert(Obj::num_copied == static_cast<int>(N));
+        assert(table.Size() == N + 1 && table[0].id == ID && table[N].id == ID);
+        assert(snapshot.Size() == N && snapshot[0].id == 0);
+
+        // Изменения после нового снимка снова отделяют содержимое и в снимок не попадают
+        const SharedVector<Obj> second = table.Snapshot();
+        table.Set(1, Obj(ID + 1));
+        const size_t size = table.Modify([](Vector<Obj>& values) {
+            values.EmplaceBack(ID + 2);
+            return values.Size();
+        });
+        assert(size == N + 2 && table[1].id == ID + 1 && table[N + 1].id == ID + 2);
+        assert(second.Size() == N + 1 && second[1].id == 0 && !second.IsShared());
+        table.Erase(N + 1);
+        table.Resize(N + 1);
+
+        SharedVector<Obj> other = snapshot;
+        other.Clear();
+        assert(other.Size() == 0 && other.begin() == other.end());
+        assert(snapshot.Size() == N);
+        other.PushBack(Obj(ID));
+        other = table;
+        assert(other.Data() == table.Data());
+        table.PopBack();
+        assert(other.Size() == N + 1 && table.Size() == N);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        SharedVector<Obj> table{Vector<Obj>(N)};
+        table.Modify([](Vector<Obj>& values) {
+            values[N / 2].throw_on_copy = true;
+        });
+        const SharedVector<Obj> snapshot = table;
+        try {
+            table.PushBack(Obj(ID));
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(table.IsShared() && table.Data() == snapshot.Data() && table.Size() == N);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(N));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Писатель публикует версии, читатели берут снимки и проверяют их целостность
+        const int VERSIONS = 200;
+        Vector<int> initial;
+        initial.Resize(N);
+        SharedVector<int> published(std::move(initial));
+        std::atomic<bool> done{false};
+        std::mutex mutex;
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([&] {
+                while (!done.load()) {
+                    SharedVector<int> snapshot;
+                    {
+                        std::lock_guard lock(mutex);
+                        snapshot = published;
+                    }
+                    for (int value : snapshot) {
+                        assert(value == snapshot[0]);
+                    }
+                }
+            });
+        }
+        SharedVector<int> writer = published;
+        for (int version = 1; version <= VERSIONS; ++version) {
+            for (size_t i = 0; i < N; ++i) {
+                writer.Set(i, version);
+            }
+            std::lock_guard lock(mutex);
+            published = writer;
+        }
+        done = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        assert(published[N - 1] == VERSIONS);
+    }
+}
+
+void Test35() {
+    const size_t N = 8;
+    const int ID = 42;
+    using namespace std::literals;
+    {
+        Vector<Obj> v;
+        v.Reserve(N * 2);
+        for (size_t i = 0; i < N; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        // Копия создается прямо на месте: без временного объекта и лишнего перемещения
+        Obj::ResetCounters();
+        const Obj obj(ID);
+        v.Insert(v.begin() + 1, obj);
+        assert(Obj::num_copied == 1);
+        assert(Obj::num_moved == 1 && Obj::num_move_assigned == static_cast<int>(N - 2));
+        assert(Obj::num_destroyed == 1);
+        assert(v[1].id == ID && v[2].id == 1 && v[N].id == static_cast<int>(N - 1));
+
+        Obj::ResetCounters();
+        v.Emplace(v.begin(), ID + 1);
+        assert(Obj::num_constructed_with_id == 1 && Obj::num_moved == 1 && Obj::num_destroyed == 1);
+        assert(v[0].id == ID + 1 && v[2].id == ID);
+
+        // Аргумент из сдвигаемого хвоста берется с его новой позиции
+        Obj::ResetCounters();
+        v.Insert(v.begin(), v[2]);
+        assert(Obj::num_copied == 1 && Obj::num_moved == 1);
+        assert(v[0].id == ID && v[3].id == ID);
+        v.Insert(v.begin() + 1, std::move(v[v.Size() - 1]));
+        assert(v[1].id == static_cast<int>(N - 1) && Obj::num_copied == 1);
+
+        // Ссылка на поле элемента обнаруживается по адресу, и тогда нужен временный объект
+        Obj::ResetCounters();
+        v.Emplace(v.begin(), v[2].id);
+        assert(Obj::num_constructed_with_id == 1 && Obj::num_move_assigned == static_cast<int>(v.Size() - 1));
+        assert(v[0].id == ID + 1 && v[3].id == ID + 1);
+
+        // Если конструктор бросит исключение, вектор не меняется
+        std::vector<int> ids;
+        for (const Obj& item : v) {
+            ids.push_back(item.id);
+        }
+        Obj bad(ID);
+        bad.throw_on_copy = true;
+        const int alive = Obj::GetAliveObjectCount();
+        try {
+            v.Insert(v.begin() + 2, bad);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == ids.size() && Obj::GetAliveObjectCount() == alive);
+        assert(std::equal(v.begin(), v.end(), ids.begin(), [](const Obj& item, int id) {
+            return item.id == id;
+        }));
+    }
+    {
+        Vector<std::string> v;
+        v.Reserve(N * 2);
+        for (size_t i = 0; i < N; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+        v.Emplace(v.begin(), "head");
+        v.Insert(v.begin() + 1, v[3]);
+        // Указатель внутрь короткой строки, которая сдвинется
+        v.Emplace(v.begin(), v[5].c_str());
+        v.Emplace(v.begin() + 1, "long string that does not fit into the inline buffer"s);
+        assert(v.Size() == N + 4);
+        assert(v[0] == "3"s && v[2] == "head"s && v[3] == "2"s && v[7] == "3"s);
+        assert(v[1].size() > 16 && v[N + 3] == std::to_string(N - 1));
+    }
+    {
+        // Без noexcept-перемещения элементы копируются при реаллокации, все до позиции вставки и после нее
+        ThrowingMoveObj::num_alive = 0;
+        Vector<ThrowingMoveObj> v;
+        for (size_t i = 0; i < N; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        assert(v.Size() == v.Capacity());
+        ThrowingMoveObj::num_moved = 0;
+        v.Emplace(v.begin() + N / 2, ID);
+        assert(ThrowingMoveObj::num_moved == 0);
+        for (size_t i = 0; i <= N; ++i) {
+            const int expected = i < N / 2 ? static_cast<int>(i) : i == N / 2 ? ID : static_cast<int>(i - 1);
+            assert(v[i].id == expected);
         }
-        Dump();
-    } catch (...) {
+        assert(ThrowingMoveObj::num_alive == static_cast<int>(N + 1));
     }
+    assert(ThrowingMoveObj::num_alive == 0);
 }
 
 int main() {
@@ -649,7 +3005,35 @@ int main() {
         Test4();
         Test5();
         Test6();
-        Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
+        Test35();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
@@ -0,0 +1,279 @@
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "vector.h"
+
+// Вектор тривиально копируемых элементов, хранящихся прямо в отображенном в память файле.
+// Файл начинается с заголовка, за которым идут элементы, поэтому повторное открытие не требует
+// разбора: страницы подгружаются по мере обращения. Рост выполняется через ftruncate и mremap.
+// Ошибки системных вызовов сообщаются исключением std::system_error
+template <typename T, typename GrowthPolicy = DoublingGrowth>
+class MappedVector {
+    static_assert(std::is_trivially_copyable_v<T>, "MappedVector requires trivially copyable elements");
+
+    struct Header {
+        uint64_t magic;
+        uint64_t element_size;
+        uint64_t size;
+    };
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // Элементы начинаются с этого смещения, чтобы сохранить выравнивание T в файле
+    static constexpr size_t HEADER_SIZE = alignof(T) > 64 ? alignof(T) : 64;
+    static constexpr uint64_t MAGIC = 0x524f544345564d41;  // "AMVECTOR"
+
+    iterator begin() noexcept { return Data(); }
+    iterator end() noexcept { return Data() + Size(); }
+    const_iterator cbegin() const noexcept { return const_cast<MappedVector&>(*this).begin(); }
+    const_iterator cend() const noexcept { return const_cast<MappedVector&>(*this).end(); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    // Открывает файл или создает пустой. Файл, созданный для элементов другого размера, не открывается
+    explicit MappedVector(const std::string& path) {
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            ThrowSystemError("open " + path);
+        }
+        try {
+            struct stat st;
+            if (fstat(fd_, &st) != 0) {
+                ThrowSystemError("fstat " + path);
+            }
+            const bool is_new = st.st_size == 0;
+            if (is_new && ftruncate(fd_, HEADER_SIZE) != 0) {
+                ThrowSystemError("ftruncate " + path);
+            }
+            const size_t length = is_new ? HEADER_SIZE : static_cast<size_t>(st.st_size);
+            if (length < HEADER_SIZE) {
+                throw std::runtime_error(path + " is not a MappedVector file");
+            }
+            Map(length);
+            if (is_new) {
+                *GetHeader() = Header{MAGIC, sizeof(T), 0};
+            }
+            const Header& header = *GetHeader();
+            if (header.magic != MAGIC || header.element_size != sizeof(T) || header.size > capacity_) {
+                throw std::runtime_error(path + " is not a MappedVector file of this element type");
+            }
+        } catch (...) {
+            Close();
+            throw;
+        }
+    }
+
+    MappedVector(const MappedVector&) = delete;
+    MappedVector& operator=(const MappedVector&) = delete;
+
+    MappedVector(MappedVector&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1))
+        , mapping_(std::exchange(other.mapping_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0)) {}
+
+    MappedVector& operator=(MappedVector&& other) noexcept {
+        if (this != &other) {
+            Close();
+            fd_ = std::exchange(other.fd_, -1);
+            mapping_ = std::exchange(other.mapping_, nullptr);
+            capacity_ = std::exchange(other.capacity_, 0);
+        }
+        return *this;
+    }
+
+    // Содержимое остается в файле; емкость тоже сохраняется
+    ~MappedVector() {
+        Close();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= capacity_) { return; }
+        Remap(new_capacity);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size > capacity_) {
+            Reserve(NextCapacity(new_size));
+        }
+        if (new_size > Size()) {
+            std::uninitialized_value_construct_n(end(), new_size - Size());
+        }
+        SetSize(new_size);
+    }
+
+    // Уменьшает файл до размера данных
+    void ShrinkToFit() {
+        if (Size() < capacity_) {
+            Remap(Size());
+        }
+    }
+
+    void Clear() noexcept {
+        SetSize(0);
+    }
+
+    void PopBack() noexcept {
+        assert(Size());
+        SetSize(Size() - 1);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        const size_t size = Size();
+        if (size == capacity_) {
+            // Аргументы могут ссылаться на элементы, которые переедут при mremap
+            T value(std::forward<Args>(args)...);
+            Reserve(NextCapacity(size + 1));
+            new (Data() + size) T(std::move(value));
+        } else {
+            new (Data() + size) T(std::forward<Args>(args)...);
+        }
+        SetSize(size + 1);
+        return Data()[size];
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        assert(pos >= begin() && pos <= end());
+        const size_t new_pos = pos - begin();
+        T value(std::forward<Args>(args)...);
+        if (Size() == capacity_) {
+            Reserve(NextCapacity(Size() + 1));
+        }
+        detail::EmplaceInCapacity(Data(), Size(), new_pos, std::move(value));
+        SetSize(Size() + 1);
+        return begin() + new_pos;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Erase(const_iterator pos) noexcept {
+        assert(pos >= begin() && pos < end());
+        const size_t new_pos = pos - begin();
+        detail::EraseAt(Data(), Size(), new_pos);
+        SetSize(Size() - 1);
+        return begin() + new_pos;
+    }
+
+    // Синхронно записывает изменения на диск. Без вызова они попадут туда при выгрузке страниц ядром
+    void Flush() {
+        if (msync(mapping_, HEADER_SIZE + capacity_ * sizeof(T), MS_SYNC) != 0) {
+            ThrowSystemError("msync");
+        }
+    }
+
+    size_t Size() const noexcept {
+        return mapping_ != nullptr ? GetHeader()->size : 0;
+    }
+
+    size_t Capacity() const noexcept {
+        return capacity_;
+    }
+
+    T* Data() noexcept {
+        return reinterpret_cast<T*>(static_cast<char*>(mapping_) + HEADER_SIZE);
+    }
+
+    const T* Data() const noexcept {
+        return const_cast<MappedVector&>(*this).Data();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<MappedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Size());
+        return Data()[index];
+    }
+
+private:
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    size_t capacity_ = 0;
+
+    [[noreturn]] static void ThrowSystemError(const std::string& what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    Header* GetHeader() noexcept {
+        return static_cast<Header*>(mapping_);
+    }
+
+    const Header* GetHeader() const noexcept {
+        return static_cast<const Header*>(mapping_);
+    }
+
+    void SetSize(size_t size) noexcept {
+        GetHeader()->size = size;
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::NextCapacity(capacity_, required, sizeof(T));
+    }
+
+    void Map(size_t length) {
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            ThrowSystemError("mmap");
+        }
+        mapping_ = p;
+        capacity_ = (length - HEADER_SIZE) / sizeof(T);
+    }
+
+    // Меняет размер файла и отображения. Если mremap не удался, файл возвращается к прежнему размеру
+    void Remap(size_t new_capacity) {
+        const size_t old_length = HEADER_SIZE + capacity_ * sizeof(T);
+        const size_t new_length = HEADER_SIZE + new_capacity * sizeof(T);
+        if (new_length > old_length && ftruncate(fd_, new_length) != 0) {
+            ThrowSystemError("ftruncate");
+        }
+        void* p = mremap(mapping_, old_length, new_length, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) {
+            const int error = errno;
+            if (new_length > old_length) {
+                (void)ftruncate(fd_, old_length);
+            }
+            errno = error;
+            ThrowSystemError("mremap");
+        }
+        mapping_ = p;
+        capacity_ = new_capacity;
+        if (new_length < old_length) {
+            // Если файл не уменьшился, лишний хвост лишь станет емкостью при следующем открытии
+            (void)ftruncate(fd_, new_length);
+        }
+    }
+
+    void Close() noexcept {
+        if (mapping_ != nullptr) {
+            munmap(mapping_, HEADER_SIZE + capacity_ * sizeof(T));
+            mapping_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+        capacity_ = 0;
+    }
+};
@@ -0,0 +1,220 @@
+
+#pragma once
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include "vector.h"
+
+// Настройки MmapAllocator. Сравниваются при сравнении аллокаторов: буфер, выделенный с одними
+// настройками, освобождается только аллокатором с теми же
+struct MmapOptions {
+    enum class Pages {
+        // Обычные страницы
+        NORMAL,
+        // Прозрачные огромные страницы: madvise(MADV_HUGEPAGE) на выровненном по 2 МБ отображении
+        TRANSPARENT_HUGE,
+        // Явные огромные страницы MAP_HUGETLB. Если их не зарезервировано, используются прозрачные
+        EXPLICIT_HUGE,
+    };
+
+    enum class Numa {
+        // Политика потока, обычно размещение на узле первого обратившегося к странице потока
+        DEFAULT,
+        // Только узлы из node_mask
+        BIND,
+        // Страницы по очереди на узлах из node_mask
+        INTERLEAVE,
+    };
+
+    Pages pages = Pages::TRANSPARENT_HUGE;
+    Numa numa = Numa::DEFAULT;
+    // Бит i соответствует узлу NUMA с номером i
+    uint64_t node_mask = 0;
+    // Количество потоков, которые сразу после выделения касаются всех страниц, чтобы ядро разместило их
+    // заранее, а не при первой записи. 0 оставляет размещение на первое обращение
+    size_t prefault_threads = 0;
+    // Блоки меньше этого размера выделяются через operator new: отдельное отображение для них
+    // обходится дороже, чем экономит
+    size_t min_mmap_bytes = size_t{2} << 20;
+
+    bool operator==(const MmapOptions& other) const noexcept {
+        return pages == other.pages && numa == other.numa && node_mask == other.node_mask
+            && prefault_threads == other.prefault_threads && min_mmap_bytes == other.min_mmap_bytes;
+    }
+
+    bool operator!=(const MmapOptions& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+// Аллокатор для больших векторов, который выделяет память отображениями mmap с огромными страницами
+// и заданной политикой NUMA. Умеет reallocate через mremap, поэтому Vector тривиально перемещаемых
+// типов растет без копирования. Политика NUMA и огромные страницы считаются подсказкой: если ядро
+// их не поддерживает, память все равно выделяется
+template <typename T>
+class MmapAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    MmapAllocator() = default;
+
+    explicit MmapAllocator(const MmapOptions& options) noexcept
+        : options_(options) {}
+
+    template <typename U>
+    MmapAllocator(const MmapAllocator<U>& other) noexcept
+        : options_(other.GetOptions()) {}
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        if (!IsMapped(n)) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+        const size_t length = MappingLength(n);
+        void* p = MAP_FAILED;
+        if (options_.pages == MmapOptions::Pages::EXPLICIT_HUGE) {
+            p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+        if (p == MAP_FAILED) {
+            p = MapAligned(length);
+        }
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        Prepare(static_cast<char*>(p), length);
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (!IsMapped(n)) {
+            ::operator delete(p, std::align_val_t{alignof(T)});
+            return;
+        }
+        munmap(p, MappingLength(n));
+    }
+
+    // Переотображает блок, сохраняя содержимое. Между блоками из operator new и из mmap содержимое
+    // копировать придется, поэтому в этом случае возвращает nullptr и оставляет блок на месте
+    T* reallocate(T* p, size_t old_n, size_t new_n) noexcept {
+        if (new_n > std::numeric_limits<size_t>::max() / sizeof(T) || !IsMapped(old_n) || !IsMapped(new_n)) {
+            return nullptr;
+        }
+        const size_t old_length = MappingLength(old_n);
+        const size_t new_length = MappingLength(new_n);
+        if (old_length == new_length) {
+            return p;
+        }
+        // Сначала блок пробует вырасти на месте. Если не выходит, он переотображается в заранее
+        // выровненную область, чтобы огромные страницы остались возможны
+        void* new_p = mremap(p, old_length, new_length, 0);
+        if (new_p == MAP_FAILED) {
+            void* target = MapAligned(new_length);
+            if (target == MAP_FAILED) {
+                return nullptr;
+            }
+            new_p = mremap(p, old_length, new_length, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+            if (new_p == MAP_FAILED) {
+                munmap(target, new_length);
+                return nullptr;
+            }
+        }
+        if (new_length > old_length) {
+            Prepare(static_cast<char*>(new_p) + old_length, new_length - old_length);
+        }
+        return static_cast<T*>(new_p);
+    }
+
+    const MmapOptions& GetOptions() const noexcept {
+        return options_;
+    }
+
+    template <typename U>
+    bool operator==(const MmapAllocator<U>& other) const noexcept {
+        return options_ == other.GetOptions();
+    }
+
+    template <typename U>
+    bool operator!=(const MmapAllocator<U>& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    MmapOptions options_;
+
+    bool IsMapped(size_t n) const noexcept {
+        return n * sizeof(T) >= options_.min_mmap_bytes;
+    }
+
+    static size_t SystemPageSize() noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return page_size;
+    }
+
+    size_t PageSize() const noexcept {
+        return options_.pages == MmapOptions::Pages::NORMAL ? SystemPageSize() : HUGE_PAGE_SIZE;
+    }
+
+    // Отображает length байт по адресу, кратному PageSize(): прозрачные огромные страницы ядро
+    // может использовать только в выровненных по 2 МБ участках
+    void* MapAligned(size_t length) const noexcept {
+        const size_t alignment = PageSize();
+        const size_t padded = length + alignment - SystemPageSize();
+        void* p = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return p;
+        char* first = static_cast<char*>(p);
+        char* aligned = first + (alignment - reinterpret_cast<uintptr_t>(first) % alignment) % alignment;
+        if (aligned != first) {
+            munmap(first, aligned - first);
+        }
+        if (const size_t tail = first + padded - (aligned + length); tail != 0) {
+            munmap(aligned + length, tail);
+        }
+        return aligned;
+    }
+
+    size_t MappingLength(size_t n) const noexcept {
+        const size_t page_size = PageSize();
+        return (n * sizeof(T) + page_size - 1) / page_size * page_size;
+    }
+
+    // Применяет к только что отображенному диапазону политику страниц и NUMA и при необходимости
+    // касается его страниц. Ошибки madvise и mbind игнорируются
+    void Prepare(char* first, size_t length) const noexcept {
+        if (options_.pages != MmapOptions::Pages::NORMAL) {
+            madvise(first, length, MADV_HUGEPAGE);
+        }
+        if (options_.numa != MmapOptions::Numa::DEFAULT) {
+            const unsigned long mask = options_.node_mask;
+            const int mode = options_.numa == MmapOptions::Numa::BIND ? MPOL_BIND : MPOL_INTERLEAVE;
+            syscall(SYS_mbind, first, length, mode, &mask, sizeof(mask) * 8, 0);
+        }
+        if (options_.prefault_threads == 0) return;
+        // Одного байта на страницу достаточно, чтобы ядро выделило ее на узле касающегося потока
+        // или по политике mbind
+        const size_t page_size = SystemPageSize();
+        const size_t num_pages = length / page_size;
+        const size_t chunks = std::min(options_.prefault_threads, std::max<size_t>(num_pages, 1));
+        detail::RunInParallel(chunks, [=](size_t i) noexcept {
+            const auto [begin, end] = detail::ChunkBounds(num_pages, chunks, i);
+            for (size_t page = begin; page < end; ++page) {
+                reinterpret_cast<volatile char*>(first)[page * page_size] = 0;
+            }
+        });
+    }
+};
@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include "vector.h"
+
+// Набор локальных буферов для потоков, которые параллельно собирают элементы одного результата.
+// Поток с номером i добавляет элементы только в Local(i), без синхронизации. Collect вычисляет
+// итоговый размер, выделяет память один раз и переносит буферы в результат параллельно
+template <typename T, typename Allocator = std::allocator<T>>
+class ParallelCollector {
+    // Буферы соседних потоков не делят кэш-линию, иначе запись size_ одного потока
+    // сбрасывала бы кэш у соседа
+    struct alignas(64) LocalBuffer : Vector<T, Allocator> {
+        using Vector<T, Allocator>::Vector;
+
+        LocalBuffer() = default;
+    };
+
+public:
+    explicit ParallelCollector(size_t num_buffers, const Allocator& alloc = Allocator())
+        : alloc_(alloc) {
+        buffers_.Reserve(num_buffers);
+        for (size_t i = 0; i < num_buffers; ++i) {
+            buffers_.EmplaceBack(alloc);
+        }
+    }
+
+    Vector<T, Allocator>& Local(size_t index) noexcept {
+        return buffers_[index];
+    }
+
+    size_t NumBuffers() const noexcept {
+        return buffers_.Size();
+    }
+
+    // Суммарный размер буферов. Вызывать, когда потоки закончили добавление
+    size_t Size() const noexcept {
+        size_t size = 0;
+        for (const LocalBuffer& buffer : buffers_) {
+            size += buffer.Size();
+        }
+        return size;
+    }
+
+    // Дописывает элементы всех буферов в конец result в порядке номеров буферов.
+    // Буферы становятся пустыми и могут использоваться повторно
+    void CollectInto(Vector<T, Allocator>& result) {
+        result.ParallelAppend(buffers_.begin(), buffers_.end());
+    }
+
+    Vector<T, Allocator> Collect() {
+        Vector<T, Allocator> result(alloc_);
+        CollectInto(result);
+        return result;
+    }
+
+private:
+    Allocator alloc_;
+    Vector<LocalBuffer> buffers_;
+};
@@ -0,0 +1,164 @@
+
+#pragma once
+
+#include <atomic>
+
+#include "vector.h"
+
+// Vector с разделяемым неизменяемым содержимым. Копия, в том числе Snapshot(), стоит одного атомарного
+// увеличения счетчика ссылок и не копирует элементы, поэтому снимок можно раздать любому числу
+// читающих потоков. Изменяющие методы и Modify сначала отделяют содержимое: если его разделяет
+// кто-то еще, оно копируется, и только после этого меняется. Снимки, взятые раньше, видят прежнее
+// содержимое. Ссылок на изменяемые элементы, переживающих вызов, контейнер не отдает.
+// Как и у std::shared_ptr, разные объекты с общим содержимым можно использовать из разных потоков
+// одновременно, а один объект нельзя менять одновременно с любым другим обращением к нему
+template <typename T, typename Allocator = std::allocator<T>>
+class SharedVector {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using const_iterator = const T*;
+
+    const_iterator cbegin() const noexcept { return block_ != nullptr ? block_->values.begin() : nullptr; }
+    const_iterator cend() const noexcept { return block_ != nullptr ? block_->values.end() : nullptr; }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    SharedVector() = default;
+
+    // Забирает элементы values без копирования
+    explicit SharedVector(Vector<T, Allocator> values)
+        : block_(new Block{std::move(values)}) {}
+
+    SharedVector(const SharedVector& other) noexcept
+        : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    SharedVector(SharedVector&& other) noexcept
+        : block_(std::exchange(other.block_, nullptr)) {}
+
+    SharedVector& operator=(const SharedVector& other) noexcept {
+        SharedVector(other).Swap(*this);
+        return *this;
+    }
+
+    SharedVector& operator=(SharedVector&& other) noexcept {
+        SharedVector(std::move(other)).Swap(*this);
+        return *this;
+    }
+
+    ~SharedVector() {
+        Release();
+    }
+
+    // Снимок текущего содержимого за O(1)
+    SharedVector Snapshot() const noexcept {
+        return *this;
+    }
+
+    // Разделяет ли содержимое кто-то еще, то есть скопирует ли его следующее изменение
+    bool IsShared() const noexcept {
+        return block_ != nullptr && block_->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    // Вызывает f(Vector<T, Allocator>&) для отделенного содержимого и возвращает его результат по
+    // значению. Ссылка на вектор действительна только внутри f: снимок, взятый позже, разделил бы
+    // изменяемое содержимое, поэтому сохранять ее и брать снимки этого объекта внутри f нельзя
+    template <typename F>
+    auto Modify(F f) {
+        Vector<T, Allocator>& values = Detach();
+        if constexpr (std::is_void_v<std::invoke_result_t<F&, Vector<T, Allocator>&>>) {
+            f(values);
+            assert(!IsShared() && "Snapshot taken inside Modify");
+        } else {
+            auto result = f(values);
+            assert(!IsShared() && "Snapshot taken inside Modify");
+            return result;
+        }
+    }
+
+    template <typename S>
+    void Set(size_t index, S&& value) {
+        assert(index < Size());
+        Detach()[index] = std::forward<S>(value);
+    }
+
+    template <typename... Args>
+    void EmplaceBack(Args&&... args) {
+        Detach().EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    template <typename S>
+    void PushBack(S&& value) {
+        EmplaceBack(std::forward<S>(value));
+    }
+
+    void PopBack() {
+        Detach().PopBack();
+    }
+
+    void Resize(size_t new_size) {
+        Detach().Resize(new_size);
+    }
+
+    void Erase(size_t index) {
+        assert(index < Size());
+        Vector<T, Allocator>& values = Detach();
+        values.Erase(values.begin() + index);
+    }
+
+    // Отказывается от содержимого, не копируя его, даже если оно разделяется
+    void Clear() noexcept {
+        Release();
+        block_ = nullptr;
+    }
+
+    void Swap(SharedVector& other) noexcept {
+        std::swap(block_, other.block_);
+    }
+
+    size_t Size() const noexcept {
+        return block_ != nullptr ? block_->values.Size() : 0;
+    }
+
+    const T* Data() const noexcept {
+        return cbegin();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < Size());
+        return block_->values[index];
+    }
+
+private:
+    struct Block {
+        Vector<T, Allocator> values;
+        std::atomic<size_t> refs{1};
+    };
+
+    Block* block_ = nullptr;
+
+    // Содержимое для изменения. Если оно разделяется, сначала копируется; при исключении во время
+    // копирования вектор не меняется. Ссылку нельзя отдавать наружу: после следующего снимка
+    // изменения через нее попали бы и в снимок
+    Vector<T, Allocator>& Detach() {
+        if (block_ == nullptr) {
+            block_ = new Block{};
+        } else if (IsShared()) {
+            Block* copy = new Block{block_->values};
+            Release();
+            block_ = copy;
+        }
+        return block_->values;
+    }
+
+    // Последний владелец должен увидеть все обращения остальных к содержимому до его уничтожения
+    void Release() noexcept {
+        if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete block_;
+        }
+    }
+};
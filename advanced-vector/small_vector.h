@@ -0,0 +1,276 @@
+
+#pragma once
+
+#include "vector.h"
+
+// Вектор с внутренним буфером на N элементов: пока элементы в нем помещаются, память в куче не выделяется,
+// а при переполнении они переносятся в RawMemory. Вставка, удаление и перенос элементов выполняются
+// теми же функциями, что и в Vector, поэтому гарантии безопасности исключений совпадают
+template <typename T, size_t N, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
+class SmallVector {
+    static_assert(N > 0, "Inline capacity must be positive");
+
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+public:
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    iterator begin() noexcept { return IsInline() ? InlineData() : heap_.GetAddress(); }
+    iterator end() noexcept { return size_ + begin(); }
+    const_iterator cbegin() const noexcept { return const_cast<SmallVector&>(*this).begin(); }
+    const_iterator cend() const noexcept { return size_ + cbegin(); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    SmallVector() = default;
+
+    explicit SmallVector(const Allocator& alloc) noexcept
+        : heap_(alloc) {}
+
+    explicit SmallVector(size_t size, const Allocator& alloc = Allocator())
+        : heap_(size > N ? size : 0, alloc)
+        , size_(size) {
+        std::uninitialized_value_construct_n(begin(), size);
+    }
+
+    SmallVector(const SmallVector& other)
+        : SmallVector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {}
+
+    SmallVector(const SmallVector& other, const Allocator& alloc)
+        : heap_(other.size_ > N ? other.size_ : 0, alloc)
+        , size_(other.size_) {
+        std::uninitialized_copy_n(other.begin(), size_, begin());
+    }
+
+    // Из внутреннего буфера элементы переносятся по одному, буфер в куче забирается целиком
+    SmallVector(SmallVector&& other) noexcept(NOTHROW_RELOCATE)
+        : heap_(std::move(other.heap_)) {
+        if (IsInline()) {
+            detail::UninitializedRelocateN(other.begin(), other.size_, InlineData());
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this == &other) return *this;
+        if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+            if (GetAllocator() != other.GetAllocator()) {
+                // Текущий буфер нельзя переиспользовать: он должен быть освобожден своим аллокатором
+                SmallVector other_copy(other, other.GetAllocator());
+                Replace(other_copy);
+                return *this;
+            }
+        }
+        if (other.size_ <= Capacity()) {
+            AssignNotSwap(other.begin(), other.size_);
+        }
+        else {
+            SmallVector other_copy(other, GetAllocator());
+            Swap(other_copy);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(NOTHROW_RELOCATE
+                                                         && (AllocTraits::propagate_on_container_move_assignment::value
+                                                             || (AllocTraits::is_always_equal::value
+                                                                 && std::is_nothrow_move_assignable_v<T>))) {
+        if (this == &other) return *this;
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            Replace(other);
+        }
+        else if (!other.IsInline() && (AllocTraits::is_always_equal::value || GetAllocator() == other.GetAllocator())) {
+            std::destroy_n(begin(), size_);
+            size_ = 0;
+            heap_.Swap(other.heap_);
+            std::swap(size_, other.size_);
+        }
+        else if (other.size_ <= Capacity()) {
+            AssignNotSwap(std::make_move_iterator(other.begin()), other.size_);
+        }
+        else {
+            SmallVector other_copy(GetAllocator());
+            other_copy.Reserve(other.size_);
+            std::uninitialized_move_n(other.begin(), other.size_, other_copy.begin());
+            other_copy.size_ = other.size_;
+            *this = std::move(other_copy);
+        }
+        return *this;
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) { return; }
+        RawMemory<T, Allocator> new_data(new_capacity, heap_.GetAllocator());
+        detail::UninitializedRelocateN(begin(), size_, new_data.GetAddress());
+        heap_.Swap(new_data);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+        }
+        if (new_size > size_) {
+            if (new_size > Capacity()) {
+                Reserve(NextCapacity(new_size));
+            }
+            std::uninitialized_value_construct_n(end(), new_size - size_);
+        }
+        size_ = new_size;
+    }
+
+    void PopBack() {
+        assert(size_);
+        std::destroy_at(begin() + --size_);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ < Capacity()) {
+            new (end()) T(std::forward<Args>(args)...);
+            ++size_;
+            return *(end() - 1);
+        }
+        RawMemory<T, Allocator> new_data(NextCapacity(size_ + 1), heap_.GetAllocator());
+        detail::UninitializedRelocateAndEmplace(begin(), size_, new_data.GetAddress(), size_, std::forward<Args>(args)...);
+        heap_.Swap(new_data);
+        return heap_[size_++];
+    }
+
+    template <typename S>
+    void PushBack(S&& value) {
+        EmplaceBack(std::forward<S>(value));
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        assert(pos >= begin() && pos <= end());
+        const size_t new_pos = pos - begin();
+        if (size_ < Capacity()) {
+            detail::EmplaceInCapacity(begin(), size_, new_pos, std::forward<Args>(args)...);
+            ++size_;
+            return begin() + new_pos;
+        }
+        RawMemory<T, Allocator> new_data(NextCapacity(size_ + 1), heap_.GetAllocator());
+        detail::UninitializedRelocateAndEmplace(begin(), size_, new_data.GetAddress(), new_pos, std::forward<Args>(args)...);
+        heap_.Swap(new_data);
+        ++size_;
+        return begin() + new_pos;
+    }
+
+    iterator Erase(const_iterator pos) {
+        assert(pos >= begin() && pos < end());
+        const size_t new_pos = pos - begin();
+        detail::EraseAt(begin(), size_, new_pos);
+        --size_;
+        return begin() + new_pos;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    // Как и у Vector, без propagate_on_container_swap аллокаторы векторов должны быть равны.
+    // Если внутренний буфер использует только один вектор, его элементы переносятся во внутренний
+    // буфер другого, и при исключении оба вектора не меняются. Если оба, то, как у InplaceVector,
+    // обменивается общая часть элементов, а лишние элементы переносятся
+    void Swap(SmallVector& other) noexcept(std::is_nothrow_swappable_v<T> && std::is_nothrow_move_constructible_v<T>) {
+        if constexpr (!AllocTraits::propagate_on_container_swap::value) {
+            assert(GetAllocator() == other.GetAllocator());
+        }
+        if (IsInline() && other.IsInline()) {
+            if (size_ > other.size_) {
+                other.Swap(*this);
+                return;
+            }
+            std::swap_ranges(begin(), end(), other.begin());
+            std::uninitialized_move(other.begin() + size_, other.end(), end());
+            std::destroy(other.begin() + size_, other.end());
+        }
+        else if (IsInline()) {
+            detail::UninitializedRelocateN(InlineData(), size_, other.InlineData());
+        }
+        else if (other.IsInline()) {
+            detail::UninitializedRelocateN(other.InlineData(), other.size_, InlineData());
+        }
+        heap_.Swap(other.heap_), std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    // Элементы хранятся во внутреннем буфере, а не в куче
+    bool IsInline() const noexcept {
+        return heap_.GetAddress() == nullptr;
+    }
+
+    Allocator GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SmallVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return begin()[index];
+    }
+
+    ~SmallVector() {
+        std::destroy_n(begin(), size_);
+    }
+
+private:
+    static constexpr bool NOTHROW_RELOCATE = IsTriviallyRelocatable<T>::value
+                                             || std::is_nothrow_move_constructible_v<T>;
+
+    RawMemory<T, Allocator> heap_;
+    size_t size_ = 0;
+    alignas(T) unsigned char inline_storage_[N * sizeof(T)];
+
+    T* InlineData() noexcept {
+        return std::launder(reinterpret_cast<T*>(inline_storage_));
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::NextCapacity(Capacity(), required, sizeof(T));
+    }
+
+    // Заменяет элементы и аллокатор вектора элементами и аллокатором source, source остается пустым.
+    // Бросить исключение может только перенос элементов из внутреннего буфера source: тогда вектор
+    // остается пустым со своим буфером и аллокатором, а source не меняется
+    void Replace(SmallVector& source) noexcept(NOTHROW_RELOCATE) {
+        std::destroy_n(begin(), size_);
+        size_ = 0;
+        if (source.IsInline()) {
+            detail::UninitializedRelocateN(source.InlineData(), source.size_, InlineData());
+        }
+        heap_.Swap(source.heap_);
+        size_ = std::exchange(source.size_, 0);
+    }
+
+    template <typename InputIt>
+    void AssignNotSwap(InputIt src_begin, size_t src_size) {
+        std::copy_n(src_begin, std::min(size_, src_size), begin());
+        if (size_ <= src_size) {
+            std::uninitialized_copy_n(std::next(src_begin, size_), src_size - size_, end());
+        }
+        else {
+            std::destroy_n(begin() + src_size, size_ - src_size);
+        }
+        size_ = src_size;
+    }
+};
@@ -0,0 +1,323 @@
+
+#pragma once
+
+#include <tuple>
+
+#include "vector.h"
+
+// Непрерывный участок элементов одного поля SoAVector
+template <typename T>
+class ColumnSpan {
+public:
+    using value_type = std::remove_const_t<T>;
+    using iterator = T*;
+
+    ColumnSpan(T* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {}
+
+    iterator begin() const noexcept { return data_; }
+    iterator end() const noexcept { return data_ + size_; }
+
+    T* Data() const noexcept {
+        return data_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+private:
+    T* data_;
+    size_t size_;
+};
+
+// Вектор записей из полей Ts..., каждое из которых хранится в своем RawMemory. Цикл, читающий
+// одно поле, проходит по непрерывному массиву без остальных полей, поэтому тратит кэш только на
+// нужные данные и векторизуется. Элемент представлен кортежем ссылок на поля: operator[] и
+// итераторы возвращают std::tuple<Ts&...>, который можно разобрать структурной привязкой.
+// Рост и гарантии безопасности исключений совпадают с Vector
+template <typename... Ts>
+class SoAVector {
+    static_assert(sizeof...(Ts) > 0, "SoAVector requires at least one field");
+
+    template <size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    using Storage = std::tuple<RawMemory<Ts>...>;
+
+    template <size_t I>
+    static constexpr bool IS_COPIED = detail::RelocationKindOf<Field<I>>() == RelocationKind::COPY;
+
+public:
+    using value_type = std::tuple<Ts...>;
+    using reference = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+    using iterator = detail::IndexIterator<SoAVector>;
+    using const_iterator = detail::IndexIterator<const SoAVector>;
+
+    iterator begin() noexcept { return {this, 0}; }
+    iterator end() noexcept { return {this, size_}; }
+    const_iterator cbegin() const noexcept { return {this, 0}; }
+    const_iterator cend() const noexcept { return {this, size_}; }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    SoAVector() = default;
+
+    explicit SoAVector(size_t size) {
+        Resize(size);
+    }
+
+    SoAVector(const SoAVector& other)
+        : data_(MakeStorage(other.size_)) {
+        ForEachFieldOrUndo([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            std::uninitialized_copy_n(std::get<I>(other.data_).GetAddress(), other.size_, std::get<I>(data_).GetAddress());
+        }, [&](auto i) {
+            std::destroy_n(std::get<decltype(i)::value>(data_).GetAddress(), other.size_);
+        });
+        size_ = other.size_;
+    }
+
+    SoAVector(SoAVector&& other) noexcept {
+        Swap(other);
+    }
+
+    SoAVector& operator=(const SoAVector& other) {
+        if (this != &other) {
+            SoAVector copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SoAVector& operator=(SoAVector&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    ~SoAVector() {
+        Clear();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) return;
+        Storage new_data = MakeStorage(new_capacity);
+        RelocateInto(new_data);
+        SwapStorage(data_, new_data);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            DestroyRange(data_, new_size, size_ - new_size);
+            size_ = new_size;
+            return;
+        }
+        if (new_size > Capacity()) {
+            Reserve(NextCapacity(new_size));
+        }
+        ForEachFieldOrUndo([&](auto i) {
+            std::uninitialized_value_construct_n(std::get<decltype(i)::value>(data_).GetAddress() + size_, new_size - size_);
+        }, [&](auto i) {
+            std::destroy_n(std::get<decltype(i)::value>(data_).GetAddress() + size_, new_size - size_);
+        });
+        size_ = new_size;
+    }
+
+    // Принимает по одному аргументу конструктора на поле. Новый элемент создается до переноса
+    // элементов, поэтому аргументы могут ссылаться на элементы вектора
+    template <typename... Args>
+    reference EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Ts), "EmplaceBack takes one argument per field");
+        if (size_ < Capacity()) {
+            ConstructAt(data_, size_, std::forward<Args>(args)...);
+        } else {
+            Storage new_data = MakeStorage(NextCapacity(size_ + 1));
+            ConstructAt(new_data, size_, std::forward<Args>(args)...);
+            try {
+                RelocateInto(new_data);
+            } catch (...) {
+                DestroyRange(new_data, size_, 1);
+                throw;
+            }
+            SwapStorage(data_, new_data);
+        }
+        ++size_;
+        return (*this)[size_ - 1];
+    }
+
+    void PushBack(const value_type& value) {
+        std::apply([this](const Ts&... fields) {
+            EmplaceBack(fields...);
+        }, value);
+    }
+
+    void PushBack(value_type&& value) {
+        std::apply([this](Ts&&... fields) {
+            EmplaceBack(std::move(fields)...);
+        }, std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_);
+        --size_;
+        DestroyRange(data_, size_, 1);
+    }
+
+    iterator Erase(const_iterator pos) {
+        return Erase(pos, pos + 1);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        assert(first >= cbegin() && first <= last && last <= cend());
+        const size_t pos = first - cbegin();
+        const size_t count = last - first;
+        ForEachField([&](auto i) {
+            detail::EraseRange(std::get<decltype(i)::value>(data_).GetAddress(), size_, pos, count);
+        });
+        size_ -= count;
+        return begin() + pos;
+    }
+
+    void Clear() noexcept {
+        DestroyRange(data_, 0, size_);
+        size_ = 0;
+    }
+
+    void Swap(SoAVector& other) noexcept {
+        SwapStorage(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(data_).Capacity();
+    }
+
+    // Все значения поля I подряд
+    template <size_t I>
+    ColumnSpan<Field<I>> Column() noexcept {
+        return {std::get<I>(data_).GetAddress(), size_};
+    }
+
+    template <size_t I>
+    ColumnSpan<const Field<I>> Column() const noexcept {
+        return {std::get<I>(data_).GetAddress(), size_};
+    }
+
+    reference operator[](size_t index) noexcept {
+        assert(index < size_);
+        return std::apply([index](auto&... columns) {
+            return reference(columns[index]...);
+        }, data_);
+    }
+
+    const_reference operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return std::apply([index](const auto&... columns) {
+            return const_reference(columns[index]...);
+        }, data_);
+    }
+
+private:
+    Storage data_;
+    size_t size_ = 0;
+
+    static Storage MakeStorage(size_t capacity) {
+        return Storage(RawMemory<Ts>(capacity)...);
+    }
+
+    static void SwapStorage(Storage& lhs, Storage& rhs) noexcept {
+        ForEachField([&](auto i) {
+            std::get<decltype(i)::value>(lhs).Swap(std::get<decltype(i)::value>(rhs));
+        });
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return DoublingGrowth::NextCapacity(Capacity(), required, (sizeof(Ts) + ...));
+    }
+
+    template <typename F, size_t... Is>
+    static void ForEachField(F& f, std::index_sequence<Is...>) {
+        (f(std::integral_constant<size_t, Is>{}), ...);
+    }
+
+    template <typename F>
+    static void ForEachField(F f) {
+        ForEachField(f, std::index_sequence_for<Ts...>{});
+    }
+
+    // Выполняет op для каждого поля по порядку. Если op бросает исключение, для уже обработанных
+    // полей вызывается undo
+    template <typename Op, typename Undo>
+    static void ForEachFieldOrUndo(Op op, Undo undo) {
+        size_t done = 0;
+        try {
+            ForEachField([&](auto i) {
+                op(i);
+                ++done;
+            });
+        } catch (...) {
+            ForEachField([&](auto i) {
+                if (decltype(i)::value < done) {
+                    undo(i);
+                }
+            });
+            throw;
+        }
+    }
+
+    template <typename... Args>
+    static void ConstructAt(Storage& data, size_t index, Args&&... args) {
+        auto values = std::forward_as_tuple(std::forward<Args>(args)...);
+        ForEachFieldOrUndo([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            new (std::get<I>(data).GetAddress() + index) Field<I>(std::get<I>(std::move(values)));
+        }, [&](auto i) {
+            std::destroy_at(std::get<decltype(i)::value>(data).GetAddress() + index);
+        });
+    }
+
+    static void DestroyRange(Storage& data, size_t first, size_t count) noexcept {
+        ForEachField([&](auto i) {
+            std::destroy_n(std::get<decltype(i)::value>(data).GetAddress() + first, count);
+        });
+    }
+
+    // Переносит элементы в new_data. Сначала копируются поля, которые нельзя переместить без
+    // исключений: если копирование бросит, вектор остается нетронутым. Затем остальные поля
+    // переносятся, а источники скопированных уничтожаются
+    void RelocateInto(Storage& new_data) {
+        ForEachFieldOrUndo([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            if constexpr (IS_COPIED<I>) {
+                std::uninitialized_copy_n(std::get<I>(data_).GetAddress(), size_, std::get<I>(new_data).GetAddress());
+            }
+        }, [&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            if constexpr (IS_COPIED<I>) {
+                std::destroy_n(std::get<I>(new_data).GetAddress(), size_);
+            }
+        });
+        ForEachField([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            if constexpr (IS_COPIED<I>) {
+                std::destroy_n(std::get<I>(data_).GetAddress(), size_);
+            } else {
+                detail::UninitializedRelocateN(std::get<I>(data_).GetAddress(), size_, std::get<I>(new_data).GetAddress());
+            }
+        });
+    }
+};
@@ -0,0 +1,286 @@
+
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+
+#include "vector.h"
+
+namespace detail {
+
+// Первый элемент [first, first + count), не меньший key. Сужение диапазона не ветвится: сдвиг
+// умножается на результат сравнения, поэтому неудачные предсказания переходов не тормозят поиск,
+// а загрузки следующих уровней процессор может начинать заранее. Условный оператор вместо
+// умножения GCC превращает обратно в переход
+template <typename T, typename Key, typename KeyOf, typename Compare>
+T* BranchlessLowerBound(T* first, size_t count, const Key& key, KeyOf key_of, const Compare& compare) {
+    while (count > 1) {
+        const size_t half = count / 2;
+        first += half * static_cast<size_t>(compare(key_of(first[half - 1]), key));
+        count -= half;
+    }
+    return first + (count == 1 && compare(key_of(*first), key));
+}
+
+struct Identity {
+    template <typename T>
+    const T& operator()(const T& value) const noexcept {
+        return value;
+    }
+};
+
+struct First {
+    template <typename Pair>
+    const auto& operator()(const Pair& value) const noexcept {
+        return value.first;
+    }
+};
+
+// Общая часть FlatSet и FlatMap: элементы хранятся в Vector по возрастанию ключей без повторов.
+// Поиск стоит O(log n) по непрерывной памяти, одиночная вставка и удаление сдвигают хвост за O(n)
+template <typename Key, typename Value, typename KeyOf, typename Compare, typename Allocator>
+class SortedVector {
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+    // У FlatSet итератор константный. У FlatMap через него доступна вся пара, и ключ компилятор менять
+    // не запрещает, но менять его нельзя: порядок элементов нарушится без какой-либо диагностики
+    using iterator = std::conditional_t<std::is_same_v<Key, Value>, const Value*, Value*>;
+    using const_iterator = const Value*;
+
+    iterator begin() noexcept { return data_.begin(); }
+    iterator end() noexcept { return data_.end(); }
+    const_iterator cbegin() const noexcept { return data_.cbegin(); }
+    const_iterator cend() const noexcept { return data_.cend(); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    SortedVector() = default;
+
+    explicit SortedVector(const Compare& compare, const Allocator& alloc = Allocator())
+        : data_(alloc)
+        , compare_(compare) {}
+
+    // Сортирует элементы и оставляет первый из равных по ключу
+    explicit SortedVector(Vector<Value, Allocator> values, const Compare& compare = Compare())
+        : data_(std::move(values))
+        , compare_(compare) {
+        SortUnique(0);
+    }
+
+    size_t Size() const noexcept {
+        return data_.Size();
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    void Reserve(size_t capacity) {
+        data_.Reserve(capacity);
+    }
+
+    void Clear() noexcept {
+        data_.Clear();
+    }
+
+    iterator LowerBound(const Key& key) noexcept {
+        return detail::BranchlessLowerBound(data_.begin(), data_.Size(), key, KeyOf{}, compare_);
+    }
+
+    const_iterator LowerBound(const Key& key) const noexcept {
+        return const_cast<SortedVector&>(*this).LowerBound(key);
+    }
+
+    iterator UpperBound(const Key& key) noexcept {
+        iterator it = LowerBound(key);
+        return it != end() && !compare_(key, KeyOf{}(*it)) ? it + 1 : it;
+    }
+
+    const_iterator UpperBound(const Key& key) const noexcept {
+        return const_cast<SortedVector&>(*this).UpperBound(key);
+    }
+
+    iterator Find(const Key& key) noexcept {
+        iterator it = LowerBound(key);
+        return it != end() && !compare_(key, KeyOf{}(*it)) ? it : end();
+    }
+
+    const_iterator Find(const Key& key) const noexcept {
+        return const_cast<SortedVector&>(*this).Find(key);
+    }
+
+    bool Contains(const Key& key) const noexcept {
+        return Find(key) != end();
+    }
+
+    size_t Count(const Key& key) const noexcept {
+        return Contains(key) ? 1 : 0;
+    }
+
+    // Если элемент с таким ключом уже есть, он не меняется, и возвращается false
+    std::pair<iterator, bool> Insert(const Value& value) {
+        return InsertValue(value);
+    }
+
+    std::pair<iterator, bool> Insert(Value&& value) {
+        return InsertValue(std::move(value));
+    }
+
+    // Вставляет m элементов [first, last) за O(n + m log(n + m)) вместо O(n) на элемент: пакет
+    // добавляется в конец, сортируется и сливается с прежними элементами за один проход. Как и при
+    // поэлементной вставке, элементы с уже имеющимися ключами пропускаются, а из равных в пакете
+    // остается первый. Если исключение бросит сортировка пакета, контейнер не меняется, если
+    // слияние, контейнер становится пустым
+    template <typename InputIt>
+    void InsertBatch(InputIt first, InputIt last) {
+        const size_t old_size = data_.Size();
+        data_.Append(first, last);
+        SortUnique(old_size);
+    }
+
+    size_t Erase(const Key& key) {
+        const iterator it = Find(key);
+        if (it == end()) {
+            return 0;
+        }
+        data_.Erase(it);
+        return 1;
+    }
+
+    iterator Erase(const_iterator pos) {
+        return data_.Erase(pos);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        return data_.Erase(first, last);
+    }
+
+    const Vector<Value, Allocator>& GetValues() const noexcept {
+        return data_;
+    }
+
+    // Отдает элементы вызывающему, оставляя контейнер пустым
+    Vector<Value, Allocator> Extract() noexcept {
+        return std::move(data_);
+    }
+
+    const Compare& GetCompare() const noexcept {
+        return compare_;
+    }
+
+protected:
+    Vector<Value, Allocator> data_;
+    Compare compare_;
+
+    template <typename S>
+    std::pair<iterator, bool> InsertValue(S&& value) {
+        iterator it = LowerBound(KeyOf{}(value));
+        if (it != end() && !compare_(KeyOf{}(value), KeyOf{}(*it))) {
+            return {it, false};
+        }
+        return {data_.Emplace(it, std::forward<S>(value)), true};
+    }
+
+    bool ValueLess(const Value& lhs, const Value& rhs) const {
+        return compare_(KeyOf{}(lhs), KeyOf{}(rhs));
+    }
+
+    // Упорядочивает элементы начиная с first и сливает их с уже упорядоченными [0, first)
+    void SortUnique(size_t first) {
+        const auto less = [this](const Value& lhs, const Value& rhs) {
+            return ValueLess(lhs, rhs);
+        };
+        Value* const batch = data_.begin() + first;
+        try {
+            std::stable_sort(batch, data_.end(), less);
+            Value* batch_end = std::unique(batch, data_.end(), [&less](const Value& lhs, const Value& rhs) {
+                return !less(lhs, rhs);
+            });
+            batch_end = std::remove_if(batch, batch_end, [&](const Value& value) {
+                const Value* it = detail::BranchlessLowerBound(data_.begin(), first, KeyOf{}(value), KeyOf{}, compare_);
+                return it != batch && !compare_(KeyOf{}(value), KeyOf{}(*it));
+            });
+            data_.Erase(batch_end, data_.end());
+        } catch (...) {
+            data_.Erase(batch, data_.end());
+            throw;
+        }
+        try {
+            std::inplace_merge(data_.begin(), batch, data_.end(), less);
+        } catch (...) {
+            data_.Clear();
+            throw;
+        }
+    }
+};
+
+}  // namespace detail
+
+// Упорядоченное множество поверх Vector. Быстрее узловых контейнеров на небольших таблицах, которые
+// часто читают и редко меняют: элементы лежат подряд, а поиск двоичный без ветвлений.
+// Любая вставка и удаление делают итераторы недействительными
+template <typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>>
+class FlatSet : public detail::SortedVector<Key, Key, detail::Identity, Compare, Allocator> {
+    using Base = detail::SortedVector<Key, Key, detail::Identity, Compare, Allocator>;
+
+public:
+    using Base::Base;
+};
+
+// Упорядоченное отображение поверх Vector пар ключ-значение. Значения можно менять через итераторы.
+// В отличие от std::map, элементы имеют тип std::pair<Key, T>, а не std::pair<const Key, T>: вставка и
+// удаление сдвигают их присваиванием. Поэтому it->first = ... компилируется, но вызывающий код не
+// должен менять ключи, иначе поиск по нарушенному порядку перестанет находить элементы
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<Key, T>>>
+class FlatMap : public detail::SortedVector<Key, std::pair<Key, T>, detail::First, Compare, Allocator> {
+    using Base = detail::SortedVector<Key, std::pair<Key, T>, detail::First, Compare, Allocator>;
+
+public:
+    using mapped_type = T;
+    using typename Base::iterator;
+
+    using Base::Base;
+
+    T& At(const Key& key) {
+        const iterator it = this->Find(key);
+        if (it == this->end()) {
+            throw std::out_of_range("FlatMap::At: key not found");
+        }
+        return it->second;
+    }
+
+    const T& At(const Key& key) const {
+        return const_cast<FlatMap&>(*this).At(key);
+    }
+
+    // Вставляет значение по умолчанию, если ключа нет
+    T& operator[](const Key& key) {
+        return TryEmplace(key).first->second;
+    }
+
+    // Создает значение из args, только если ключа еще нет
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> TryEmplace(K&& key, Args&&... args) {
+        iterator it = this->LowerBound(key);
+        if (it != this->end() && !this->compare_(key, it->first)) {
+            return {it, false};
+        }
+        it = this->data_.Emplace(it, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                                 std::forward_as_tuple(std::forward<Args>(args)...));
+        return {it, true};
+    }
+
+    template <typename K, typename S>
+    std::pair<iterator, bool> InsertOrAssign(K&& key, S&& value) {
+        auto [it, inserted] = TryEmplace(std::forward<K>(key), std::forward<S>(value));
+        if (!inserted) {
+            it->second = std::forward<S>(value);
+        }
+        return {it, inserted};
+    }
+};
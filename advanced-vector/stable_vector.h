@@ -0,0 +1,189 @@
+
+#pragma once
+
+#include "vector.h"
+
+namespace detail {
+
+// Наибольшая степень двойки элементов, помещающаяся в 64 КБ, но не меньше одного элемента
+template <typename T>
+constexpr size_t DefaultChunkSize() noexcept {
+    size_t size = 1;
+    while (size * 2 * sizeof(T) <= (size_t{64} << 10)) {
+        size *= 2;
+    }
+    return size;
+}
+
+}  // namespace detail
+
+// Вектор из блоков по ChunkSize элементов, каждый в своем RawMemory. При росте добавляется новый
+// блок, а элементы никогда не переносятся, поэтому ссылки и указатели на них остаются действительными,
+// а время добавления не зависит от размера. Перенос при росте затрагивает только индекс блоков.
+// Внутри блока элементы лежат подряд: ForEachSegment позволяет обрабатывать их векторизуемыми циклами
+template <typename T, size_t ChunkSize = detail::DefaultChunkSize<T>(), typename Allocator = std::allocator<T>>
+class StableVector {
+    static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "Chunk size must be a power of two");
+
+    using Chunk = RawMemory<T, Allocator>;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using iterator = detail::IndexIterator<StableVector>;
+    using const_iterator = detail::IndexIterator<const StableVector>;
+
+    static constexpr size_t CHUNK_SIZE = ChunkSize;
+
+    iterator begin() noexcept { return {this, 0}; }
+    iterator end() noexcept { return {this, size_}; }
+    const_iterator cbegin() const noexcept { return {this, 0}; }
+    const_iterator cend() const noexcept { return {this, size_}; }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+
+    StableVector() = default;
+
+    explicit StableVector(const Allocator& alloc) noexcept
+        : alloc_(alloc) {}
+
+    // Делегирующие конструкторы: если создание элемента бросит исключение, деструктор уничтожит
+    // уже созданные
+    explicit StableVector(size_t size, const Allocator& alloc = Allocator())
+        : StableVector(alloc) {
+        Resize(size);
+    }
+
+    StableVector(const StableVector& other)
+        : StableVector(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc_)) {
+        Reserve(other.size_);
+        for (const T& value : other) {
+            EmplaceBack(value);
+        }
+    }
+
+    StableVector(StableVector&& other) noexcept
+        : alloc_(other.alloc_)
+        , chunks_(std::move(other.chunks_))
+        , size_(std::exchange(other.size_, 0)) {}
+
+    StableVector& operator=(const StableVector& other) {
+        if (this != &other) {
+            StableVector copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    StableVector& operator=(StableVector&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    ~StableVector() {
+        Clear();
+    }
+
+    // Выделяет блоки под capacity элементов
+    void Reserve(size_t capacity) {
+        if (capacity <= Capacity()) return;
+        chunks_.Reserve((capacity + ChunkSize - 1) / ChunkSize);
+        while (Capacity() < capacity) {
+            chunks_.EmplaceBack(ChunkSize, alloc_);
+        }
+    }
+
+    void Resize(size_t new_size) {
+        while (size_ > new_size) {
+            PopBack();
+        }
+        Reserve(new_size);
+        while (size_ < new_size) {
+            EmplaceBack();
+        }
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            chunks_.EmplaceBack(ChunkSize, alloc_);
+        }
+        T* slot = chunks_[size_ / ChunkSize] + size_ % ChunkSize;
+        new (slot) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    template <typename S>
+    void PushBack(S&& value) {
+        EmplaceBack(std::forward<S>(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_);
+        --size_;
+        std::destroy_at(chunks_[size_ / ChunkSize] + size_ % ChunkSize);
+    }
+
+    // Уничтожает элементы, сохраняя блоки
+    void Clear() noexcept {
+        ForEachSegment([](T* data, size_t count) {
+            std::destroy_n(data, count);
+        });
+        size_ = 0;
+    }
+
+    // Освобождает блоки, целиком лежащие за концом
+    void ShrinkToFit() noexcept {
+        while (Capacity() - size_ >= ChunkSize) {
+            chunks_.PopBack();
+        }
+    }
+
+    void Swap(StableVector& other) noexcept {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+        chunks_.Swap(other.chunks_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return chunks_.Size() * ChunkSize;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<StableVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return chunks_[index / ChunkSize][index % ChunkSize];
+    }
+
+    // Вызывает f(data, count) для каждого непрерывного участка элементов по порядку
+    template <typename F>
+    void ForEachSegment(F f) {
+        for (size_t first = 0; first < size_; first += ChunkSize) {
+            f(chunks_[first / ChunkSize].GetAddress(), std::min(ChunkSize, size_ - first));
+        }
+    }
+
+    template <typename F>
+    void ForEachSegment(F f) const {
+        for (size_t first = 0; first < size_; first += ChunkSize) {
+            f(static_cast<const T*>(chunks_[first / ChunkSize].GetAddress()), std::min(ChunkSize, size_ - first));
+        }
+    }
+
+private:
+    Allocator alloc_;
+    Vector<Chunk> chunks_;
+    size_t size_ = 0;
+};
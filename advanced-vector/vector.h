@@ -1,208 +1,1047 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <new>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+// В C++20 основные операции Vector и RawMemory со стандартным аллокатором доступны при вычислении
+// констант: таблицу можно построить в constexpr-функции и скопировать в std::array, который попадет
+// в двоичный файл готовым. Память, выделенная при вычислении, должна быть освобождена там же
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+#define VECTOR_CONSTEXPR constexpr
+#else
+#define VECTOR_CONSTEXPR
+#endif
+
+// Тип можно переместить в другую память побайтовым копированием, не вызывая деструктор у источника.
+// Для пользовательских типов признак включается специализацией
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template <typename T, typename D>
+struct IsTriviallyRelocatable<std::unique_ptr<T, D>> : IsTriviallyRelocatable<D> {};
+
+// Способ, которым элементы переносятся в новый буфер при реаллокации
+enum class RelocationKind {
+    BITWISE,
+    MOVE,
+    COPY,
+};
+
+namespace detail {
+
+constexpr bool IsConstantEvaluated() noexcept {
+#if defined(__cpp_lib_is_constant_evaluated)
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+// Placement new, допустимый при вычислении констант в C++20
+template <typename T, typename... Args>
+VECTOR_CONSTEXPR T* ConstructAt(T* p, Args&&... args) {
+#if defined(__cpp_lib_constexpr_dynamic_alloc)
+    return std::construct_at(p, std::forward<Args>(args)...);
+#else
+    return new (p) T(std::forward<Args>(args)...);
+#endif
+}
+
+template <typename T>
+constexpr RelocationKind RelocationKindOf() noexcept {
+    if constexpr (IsTriviallyRelocatable<T>::value) {
+        return RelocationKind::BITWISE;
+    } else if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+        return RelocationKind::MOVE;
+    } else {
+        return RelocationKind::COPY;
+    }
+}
+
+template <typename T>
+auto MakeMoveIfNoexceptIterator(T* it) noexcept {
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+        return std::make_move_iterator(it);
+    } else {
+        return it;
+    }
+}
+
+// Переносит count элементов из first в неинициализированную память dest, разрывая последовательность
+// зазором из gap элементов перед позицией pos. Исходные элементы после переноса считаются уничтоженными.
+// Если копирование бросает исключение, исходная последовательность остается нетронутой
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedRelocateWithGap(T* first, size_t count, T* dest, size_t pos, size_t gap) {
+    assert(pos <= count);
+    if (IsConstantEvaluated()) {
+        // Исключение при вычислении констант все равно делает его ошибкой, поэтому откат не нужен
+        for (size_t i = 0; i < count; ++i) {
+            ConstructAt(dest + i + (i < pos ? 0 : gap), std::move(first[i]));
+        }
+        std::destroy_n(first, count);
+    } else if constexpr (IsTriviallyRelocatable<T>::value) {
+        if (pos != 0) {
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), pos * sizeof(T));
+        }
+        if (count != pos) {
+            std::memcpy(static_cast<void*>(dest + pos + gap), static_cast<const void*>(first + pos),
+                        (count - pos) * sizeof(T));
+        }
+    } else {
+        auto src = MakeMoveIfNoexceptIterator(first);
+        std::uninitialized_copy_n(src, pos, dest);
+        try {
+            std::uninitialized_copy_n(src + pos, count - pos, dest + pos + gap);
+        } catch (...) {
+            std::destroy_n(dest, pos);
+            throw;
+        }
+        std::destroy_n(first, count);
+    }
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedRelocateN(T* first, size_t count, T* dest) {
+    UninitializedRelocateWithGap(first, count, dest, count, 0);
+}
+
+// Создает элемент в позиции pos нового буфера dest и переносит вокруг него count элементов из first.
+// Элемент создается до переноса, поэтому аргументы могут ссылаться на переносимые элементы
+template <typename T, typename... Args>
+VECTOR_CONSTEXPR void UninitializedRelocateAndEmplace(T* first, size_t count, T* dest, size_t pos, Args&&... args) {
+    ConstructAt(dest + pos, std::forward<Args>(args)...);
+    try {
+        UninitializedRelocateWithGap(first, count, dest, pos, 1);
+    } catch (...) {
+        std::destroy_at(dest + pos);
+        throw;
+    }
+}
+
+// std::uninitialized_value_construct_n, допустимый при вычислении констант
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedValueConstructN(T* first, size_t count) {
+    if (IsConstantEvaluated()) {
+        for (size_t i = 0; i < count; ++i) {
+            ConstructAt(first + i);
+        }
+    } else {
+        std::uninitialized_value_construct_n(first, count);
+    }
+}
+
+// Побайтово переносит n тривиально копируемых элементов; диапазоны могут перекрываться
+template <typename T>
+void MemmoveN(T* dest, const T* src, size_t n) noexcept {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (n != 0) {
+        std::memmove(static_cast<void*>(dest), static_cast<const void*>(src), n * sizeof(T));
+    }
+}
+
+// Лежит ли value внутри [first, first + count)
+template <typename T>
+bool IsElementOf(const T* first, size_t count, const T& value) noexcept {
+    const std::less<const T*> less;
+    return !less(std::addressof(value), first) && less(std::addressof(value), first + count);
+}
+
+// Аргумент конструктора T, связь которого с элементами видна по адресам: сам элемент или скаляр.
+// Скаляр может лежать внутри элемента, а указатель - указывать внутрь него. Объект другого класса
+// может ссылаться на содержимое элемента незаметно, как string_view на короткую строку
+template <typename T, typename Arg>
+constexpr bool IsAddressCheckable() noexcept {
+    using U = std::decay_t<Arg>;
+    return std::is_same_v<U, T> || std::is_scalar_v<U>;
+}
+
+// Лежит ли arg, а если это указатель, то и объект, на который он указывает, в памяти [first, first + count)
+template <typename T, typename Arg>
+bool RefersInto(const T* first, size_t count, const Arg& arg) noexcept {
+    const std::less<const void*> less;
+    const auto inside = [&](const void* p) {
+        return !less(p, first) && less(p, first + count);
+    };
+    if constexpr (std::is_pointer_v<Arg> && !std::is_function_v<std::remove_pointer_t<Arg>>) {
+        if (inside(arg)) return true;
+    }
+    return inside(std::addressof(arg));
+}
+
+// Сдвигает [first + pos, first + count) на одну позицию вправо, в место за концом последовательности.
+// В позиции pos остается перемещенный элемент
 template <typename T>
-class RawMemory {
+void ShiftRight(T* first, size_t count, size_t pos) {
+    T* last = first + count;
+    new (last) T(std::move(*(last - 1)));
+    std::move_backward(first + pos, last - 1, last);
+}
+
+// Возвращает хвост на место после ShiftRight, если позиция pos пуста
+template <typename T>
+void ShiftLeft(T* first, size_t count, size_t pos) noexcept {
+    new (first + pos) T(std::move(first[pos + 1]));
+    std::move(first + pos + 2, first + count + 1, first + pos + 1);
+    std::destroy_at(first + count);
+}
+
+// Создает элемент из args в позиции pos, освобожденной ShiftRight. Если конструктор бросит
+// исключение, хвост возвращается на место
+template <typename T, typename... Args>
+void ConstructInShifted(T* first, size_t count, size_t pos, Args&&... args) {
+    std::destroy_at(first + pos);
+    try {
+        new (first + pos) T(std::forward<Args>(args)...);
+    } catch (...) {
+        ShiftLeft(first, count, pos);
+        throw;
+    }
+}
+
+// Вставляет элемент в позицию pos последовательности [first, first + count), за концом которой
+// есть место еще хотя бы для одного элемента
+template <typename T, typename... Args>
+void EmplaceInCapacity(T* first, size_t count, size_t pos, Args&&... args) {
+    T* last = first + count;
+    if (pos == count) {
+        new (last) T(std::forward<Args>(args)...);
+        return;
+    }
+    // Копия или перемещение элемента
+    constexpr bool IS_ELEMENT = sizeof...(Args) == 1 && (std::is_same_v<T, std::decay_t<Args>> && ...);
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        // Копия элемента создается на месте, если он не сдвинется вместе с хвостом. Для остальных
+        // аргументов временный объект нужен: они могут ссылаться на элементы косвенно
+        constexpr bool IS_COPY = IS_ELEMENT && std::is_nothrow_constructible_v<T, Args&&...>;
+        if constexpr (IS_COPY) {
+            if (!IsElementOf(first + pos, count - pos, args...)) {
+                MemmoveN(first + pos + 1, first + pos, count - pos);
+                new (first + pos) T(std::forward<Args>(args)...);
+                return;
+            }
+        }
+        T t(std::forward<Args>(args)...);
+        MemmoveN(first + pos + 1, first + pos, count - pos);
+        new (first + pos) T(std::move(t));
+    } else {
+        // Без временного объекта элемент создается прямо в позиции pos после сдвига хвоста. Откат
+        // при исключении сдвигает хвост обратно, поэтому перемещения не должны бросать
+        constexpr bool IN_PLACE = std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>
+                                  && (IsAddressCheckable<T, Args>() && ...);
+        if constexpr (IN_PLACE && IS_ELEMENT) {
+            // Элемент из хвоста после сдвига лежит на одну позицию правее
+            auto* src = std::addressof(args...);
+            if (IsElementOf(first + pos, count - pos, *src)) {
+                ++src;
+            }
+            ShiftRight(first, count, pos);
+            ConstructInShifted(first, count, pos, std::forward<Args...>(*src));
+            return;
+        } else if constexpr (IN_PLACE) {
+            if (!(RefersInto(first + pos, count - pos, args) || ...)) {
+                ShiftRight(first, count, pos);
+                ConstructInShifted(first, count, pos, std::forward<Args>(args)...);
+                return;
+            }
+        }
+        T t(std::forward<Args>(args)...);
+        ShiftRight(first, count, pos);
+        first[pos] = std::move(t);
+    }
+}
+
+// Удаляет n элементов начиная с позиции pos, сдвигая хвост последовательности [first, first + count) влево
+template <typename T>
+void EraseRange(T* first, size_t count, size_t pos, size_t n) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        MemmoveN(first + pos, first + pos + n, count - pos - n);
+    } else {
+        std::move(first + pos + n, first + count, first + pos);
+        std::destroy_n(first + count - n, n);
+    }
+}
+
+template <typename T>
+void EraseAt(T* first, size_t count, size_t pos) {
+    EraseRange(first, count, pos, 1);
+}
+
+template <typename It, typename Category>
+using EnableIfIteratorCategory = std::enable_if_t<std::is_convertible_v<
+    typename std::iterator_traits<It>::iterator_category, Category>>;
+
+template <typename It, typename = void>
+struct IsForwardIterator : std::false_type {};
+
+template <typename It>
+struct IsForwardIterator<It, EnableIfIteratorCategory<It, std::forward_iterator_tag>> : std::true_type {};
+
+// Итератор по последовательности из count одинаковых значений
+template <typename T>
+class RepeatIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    RepeatIterator(const T& value, size_t index) noexcept : value_(&value), index_(index) {}
+
+    reference operator*() const noexcept {return *value_;}
+    pointer operator->() const noexcept {return value_;}
+    RepeatIterator& operator++() noexcept {++index_; return *this;}
+    RepeatIterator operator++(int) noexcept {auto old = *this; ++index_; return old;}
+    bool operator==(const RepeatIterator& other) const noexcept {return index_ == other.index_;}
+    bool operator!=(const RepeatIterator& other) const noexcept {return index_ != other.index_;}
+
+private:
+    const T* value_;
+    size_t index_;
+};
+
+// Итератор произвольного доступа по контейнеру с operator[], хранящий контейнер и индекс.
+// Подходит контейнерам, элементы которых лежат не одним массивом. Если operator[] возвращает
+// прокси-объект, а не ссылку, итератор разыменовывается в него, а operator-> недоступен
+template <typename Owner>
+class IndexIterator {
 public:
-    RawMemory() = default;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename std::remove_const_t<Owner>::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = decltype(std::declval<Owner&>()[size_t{}]);
+    using pointer = std::conditional_t<std::is_reference_v<reference>, std::add_pointer_t<reference>, void>;
+
+    IndexIterator() = default;
+
+    IndexIterator(Owner* owner, size_t index) noexcept
+        : owner_(owner)
+        , index_(index) {}
+
+    // Неконстантный итератор приводится к константному
+    template <typename Other, typename = std::enable_if_t<std::is_same_v<const Other, Owner> && !std::is_same_v<Other, Owner>>>
+    IndexIterator(const IndexIterator<Other>& other) noexcept
+        : owner_(other.owner_)
+        , index_(other.index_) {}
+
+    reference operator*() const noexcept { return (*owner_)[index_]; }
+    template <typename R = reference, typename = std::enable_if_t<std::is_reference_v<R>>>
+    pointer operator->() const noexcept { return &(*owner_)[index_]; }
+    reference operator[](difference_type n) const noexcept { return (*owner_)[index_ + n]; }
+
+    IndexIterator& operator++() noexcept { ++index_; return *this; }
+    IndexIterator operator++(int) noexcept { IndexIterator it = *this; ++index_; return it; }
+    IndexIterator& operator--() noexcept { --index_; return *this; }
+    IndexIterator operator--(int) noexcept { IndexIterator it = *this; --index_; return it; }
+    IndexIterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+    IndexIterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+
+    friend IndexIterator operator+(IndexIterator it, difference_type n) noexcept { return it += n; }
+    friend IndexIterator operator+(difference_type n, IndexIterator it) noexcept { return it += n; }
+    friend IndexIterator operator-(IndexIterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+        return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+    }
+
+    friend bool operator==(const IndexIterator& lhs, const IndexIterator& rhs) noexcept { return lhs.index_ == rhs.index_; }
+    friend bool operator!=(const IndexIterator& lhs, const IndexIterator& rhs) noexcept { return lhs.index_ != rhs.index_; }
+    friend bool operator<(const IndexIterator& lhs, const IndexIterator& rhs) noexcept { return lhs.index_ < rhs.index_; }
+    friend bool operator>(const IndexIterator& lhs, const IndexIterator& rhs) noexcept { return lhs.index_ > rhs.index_; }
+    friend bool operator<=(const IndexIterator& lhs, const IndexIterator& rhs) noexcept { return lhs.index_ <= rhs.index_; }
+    friend bool operator>=(const IndexIterator& lhs, const IndexIterator& rhs) noexcept { return lhs.index_ >= rhs.index_; }
+
+private:
+    template <typename>
+    friend class IndexIterator;
+
+    Owner* owner_ = nullptr;
+    size_t index_ = 0;
+};
+
+// Выполняет task(i) для всех i из [0, count): задача 0 выполняется в текущем потоке, остальные
+// получают по отдельному потоку. Если поток создать не удалось, его задача тоже выполняется в текущем.
+// Задачи не должны бросать исключений
+template <typename Task>
+void RunInParallel(size_t count, const Task& task) {
+    if (count == 0) return;
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < count; ++i) {
+        try {
+            threads.emplace_back(std::cref(task), i);
+        } catch (...) {
+            task(i);
+        }
+    }
+    task(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Меньшие объемы параллельные алгоритмы обрабатывают в текущем потоке: создание потоков обойдется дороже
+inline constexpr size_t PARALLEL_MIN_BYTES = size_t{1} << 20;
+
+// Количество кусков, на которые разбивается обработка count элементов размером element_size.
+// num_threads == 0 означает число ядер
+inline size_t ParallelChunkCount(size_t count, size_t element_size, size_t num_threads) noexcept {
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    return std::clamp<size_t>(count / std::max<size_t>(PARALLEL_MIN_BYTES / element_size, 1), 1, num_threads);
+}
+
+// Границы куска с номером i при разбиении [0, count) на chunks почти равных кусков
+inline std::pair<size_t, size_t> ChunkBounds(size_t count, size_t chunks, size_t i) noexcept {
+    return {count / chunks * i + std::min(i, count % chunks), count / chunks * (i + 1) + std::min(i + 1, count % chunks)};
+}
+
+// Вызывает op(offset, n) для каждого куска [0, count) в отдельном потоке. Возвращает исключения,
+// брошенные кусками, по одному на кусок: у завершившихся успешно указатель пустой
+template <typename Op>
+std::vector<std::exception_ptr> RunChunks(size_t count, size_t chunks, const Op& op) {
+    std::vector<std::exception_ptr> errors(chunks);
+    RunInParallel(chunks, [&](size_t i) noexcept {
+        const auto [first, last] = ChunkBounds(count, chunks, i);
+        try {
+            op(first, last - first);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+    return errors;
+}
+
+inline void RethrowFirst(const std::vector<std::exception_ptr>& errors) {
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+template <typename Op>
+void ForEachChunk(size_t count, size_t chunks, const Op& op) {
+    if (chunks == 1) {
+        op(size_t{0}, count);
+        return;
+    }
+    RethrowFirst(RunChunks(count, chunks, op));
+}
+
+template <typename T>
+void ParallelDestroyN(T* first, size_t count, size_t chunks) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        RunInParallel(chunks, [=](size_t i) noexcept {
+            const auto [begin, end] = ChunkBounds(count, chunks, i);
+            std::destroy(first + begin, first + end);
+        });
+    }
+}
+
+// Создает count элементов в неинициализированной памяти dest кусками: construct(offset, n) создает
+// элементы [offset, offset + n) и при исключении сама уничтожает созданные. Если какой-то кусок бросит
+// исключение, уже созданные другими кусками элементы уничтожаются, а исключение пробрасывается
+template <typename T, typename Construct>
+void ParallelUninitializedConstruct(T* dest, size_t count, size_t chunks, const Construct& construct) {
+    if (chunks == 1) {
+        construct(size_t{0}, count);
+        return;
+    }
+    const std::vector<std::exception_ptr> errors = RunChunks(count, chunks, construct);
+    if (std::none_of(errors.begin(), errors.end(), [](const std::exception_ptr& error) { return error != nullptr; })) {
+        return;
+    }
+    for (size_t i = 0; i < chunks; ++i) {
+        if (!errors[i]) {
+            const auto [first, last] = ChunkBounds(count, chunks, i);
+            std::destroy(dest + first, dest + last);
+        }
+    }
+    RethrowFirst(errors);
+}
+
+// Параллельная версия UninitializedRelocateN с теми же гарантиями: элементы, перемещение которых
+// может бросить исключение, сначала копируются целиком, а исходные уничтожаются после
+template <typename T>
+void ParallelUninitializedRelocateN(T* first, size_t count, T* dest, size_t chunks) {
+    if (chunks == 1) {
+        UninitializedRelocateN(first, count, dest);
+    } else if constexpr (IsTriviallyRelocatable<T>::value || std::is_nothrow_move_constructible_v<T>) {
+        RunInParallel(chunks, [=](size_t i) noexcept {
+            const auto [begin, end] = ChunkBounds(count, chunks, i);
+            UninitializedRelocateN(first + begin, end - begin, dest + begin);
+        });
+    } else {
+        ParallelUninitializedConstruct(dest, count, chunks, [=](size_t offset, size_t n) {
+            std::uninitialized_copy_n(MakeMoveIfNoexceptIterator(first + offset), n, dest + offset);
+        });
+        ParallelDestroyN(first, count, chunks);
+    }
+}
+
+// Выравнивание буферов, которое гарантирует аллокатор: ALIGNMENT, если он его объявляет, иначе alignof(T)
+template <typename Allocator, typename = void>
+struct AllocatorAlignment : std::integral_constant<size_t, alignof(typename Allocator::value_type)> {};
+
+template <typename Allocator>
+struct AllocatorAlignment<Allocator, std::void_t<decltype(Allocator::ALIGNMENT)>>
+    : std::integral_constant<size_t, Allocator::ALIGNMENT> {};
+
+// Сообщает компилятору, что p выровнен по Alignment, чтобы циклы по элементам векторизовались
+// выровненными загрузками
+template <size_t Alignment, typename T>
+VECTOR_CONSTEXPR T* AssumeAligned(T* p) noexcept {
+#if defined(__GNUC__)
+    if (!IsConstantEvaluated()) {
+        return static_cast<T*>(__builtin_assume_aligned(p, Alignment));
+    }
+#endif
+    return p;
+}
+
+// Аллокатор может предоставить T* reallocate(T* p, size_t old_n, size_t new_n) с семантикой realloc:
+// блок расширяется на месте или переносится побайтово, а при неудаче возвращается nullptr и блок не меняется
+template <typename Allocator, typename = void>
+struct HasReallocate : std::false_type {};
+
+template <typename Allocator>
+struct HasReallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().reallocate(
+    std::declval<typename Allocator::value_type*>(), size_t{}, size_t{}))>> : std::true_type {};
+
+}  // namespace detail
+
+template <typename T, typename Allocator = std::allocator<T>>
+class RawMemory : private Allocator {
+    using AllocTraits = std::allocator_traits<Allocator>;
+    static_assert(std::is_same_v<typename AllocTraits::value_type, T>, "Allocator::value_type must be T");
+    static_assert(std::is_same_v<typename AllocTraits::pointer, T*>, "Fancy pointers are not supported");
+
+public:
+    using allocator_type = Allocator;
+
+    VECTOR_CONSTEXPR RawMemory() = default;
+
+    VECTOR_CONSTEXPR explicit RawMemory(const Allocator& alloc) noexcept : Allocator(alloc) {}
  
-    explicit RawMemory(size_t capacity) : buffer_(Allocate(capacity))
-                                        , capacity_(capacity) {}
+    VECTOR_CONSTEXPR explicit RawMemory(size_t capacity, const Allocator& alloc = Allocator()) 
+        : Allocator(alloc)
+        , buffer_(Allocate(capacity))
+        , capacity_(capacity) {}
  
     RawMemory(const RawMemory&) = delete;
     RawMemory& operator=(const RawMemory& rhs) = delete;
     
-    RawMemory(RawMemory&& other) noexcept 
-        : buffer_(std::exchange(other.buffer_, nullptr))
+    // Аллокатор копируется, а не перемещается: источник должен суметь освободить то, что у него останется
+    VECTOR_CONSTEXPR RawMemory(RawMemory&& other) noexcept 
+        : Allocator(other.GetAllocator())
+        , buffer_(std::exchange(other.buffer_, nullptr))
         , capacity_(std::exchange(other.capacity_, 0)) {}
  
-    RawMemory& operator=(RawMemory&& rhs) noexcept {
+    VECTOR_CONSTEXPR RawMemory& operator=(RawMemory&& rhs) noexcept {
         if (this != &rhs) {
             Swap(rhs);
         }
         return *this;
     }
     
-    ~RawMemory() {Deallocate(buffer_);}
+    VECTOR_CONSTEXPR ~RawMemory() {Deallocate(buffer_, capacity_);}
+
+    // Принимает владение буфером на capacity элементов, выделенным аллокатором, равным alloc
+    static VECTOR_CONSTEXPR RawMemory Adopt(T* buffer, size_t capacity, const Allocator& alloc = Allocator()) noexcept {
+        RawMemory memory(alloc);
+        memory.buffer_ = buffer;
+        memory.capacity_ = capacity;
+        return memory;
+    }
+
+    // Отдает буфер вызывающему, который теперь должен освободить его аллокатором GetAllocator()
+    VECTOR_CONSTEXPR T* Release() noexcept {
+        capacity_ = 0;
+        return std::exchange(buffer_, nullptr);
+    }
  
-    T* operator+(size_t offset) noexcept {assert(offset <= capacity_); return buffer_ + offset;}
-    const T* operator+(size_t offset) const noexcept {return const_cast<RawMemory&>(*this) + offset;}
+    VECTOR_CONSTEXPR T* operator+(size_t offset) noexcept {assert(offset <= capacity_); return buffer_ + offset;}
+    VECTOR_CONSTEXPR const T* operator+(size_t offset) const noexcept {return const_cast<RawMemory&>(*this) + offset;}
  
-    const T& operator[](size_t index) const noexcept {return const_cast<RawMemory&>(*this)[index];}
-    T& operator[](size_t index) noexcept {assert(index < capacity_); return buffer_[index];}
+    VECTOR_CONSTEXPR const T& operator[](size_t index) const noexcept {return const_cast<RawMemory&>(*this)[index];}
+    VECTOR_CONSTEXPR T& operator[](size_t index) noexcept {assert(index < capacity_); return buffer_[index];}
  
-    void Swap(RawMemory& other) noexcept {std::swap(buffer_, other.buffer_); std::swap(capacity_, other.capacity_);}
+    // Обменивает буферы вместе с аллокаторами, которыми они выделены
+    VECTOR_CONSTEXPR void Swap(RawMemory& other) noexcept {
+        using std::swap;
+        swap(GetAllocator(), other.GetAllocator());
+        std::swap(buffer_, other.buffer_);
+        std::swap(capacity_, other.capacity_);
+    }
  
-    const T* GetAddress() const noexcept {return buffer_;}
-    T* GetAddress() noexcept {return buffer_;}
-    size_t Capacity() const {return capacity_;}
+    VECTOR_CONSTEXPR const T* GetAddress() const noexcept {return buffer_;}
+    VECTOR_CONSTEXPR T* GetAddress() noexcept {return buffer_;}
+    VECTOR_CONSTEXPR size_t Capacity() const {return capacity_;}
+
+    // Меняет ёмкость средствами аллокатора, перенося содержимое побайтово, поэтому годится только
+    // для тривиально перемещаемых T. Возвращает false, если аллокатор этого не умеет или не смог
+    VECTOR_CONSTEXPR bool TryReallocate(size_t new_capacity) noexcept {
+        if constexpr (detail::HasReallocate<Allocator>::value) {
+            if (buffer_ == nullptr || new_capacity == 0) return false;
+            T* new_buffer = GetAllocator().reallocate(buffer_, capacity_, new_capacity);
+            if (new_buffer == nullptr) return false;
+            buffer_ = new_buffer;
+            capacity_ = new_capacity;
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    VECTOR_CONSTEXPR const Allocator& GetAllocator() const noexcept {return *this;}
+    VECTOR_CONSTEXPR Allocator& GetAllocator() noexcept {return *this;}
  
 private:
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
     
-    static T* Allocate(size_t n) {return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;}
-    static void Deallocate(T* buf) noexcept {operator delete(buf);}
+    VECTOR_CONSTEXPR T* Allocate(size_t n) {return n != 0 ? AllocTraits::allocate(GetAllocator(), n) : nullptr;}
+    VECTOR_CONSTEXPR void Deallocate(T* buf, size_t n) noexcept {if (buf != nullptr) AllocTraits::deallocate(GetAllocator(), buf, n);}
 }; 
 
+// Стратегия роста вычисляет новую емкость, не меньшую required, когда текущей емкости не хватает.
+// Емкость увеличивается в Numerator / Denominator раз, но не бывает меньше MinCapacity
+template <size_t Numerator, size_t Denominator = 1, size_t MinCapacity = 1>
+struct GeometricGrowth {
+    static_assert(Numerator > Denominator, "Growth factor must be greater than 1");
+    static_assert(MinCapacity > 0, "Minimal capacity must be positive");
+
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t /*element_size*/) noexcept {
+        const size_t grown = std::max(capacity * Numerator / Denominator, capacity + 1);
+        return std::max({required, grown, MinCapacity});
+    }
+};
+
+using DoublingGrowth = GeometricGrowth<2>;
+
+// Округляет размер буфера вверх до класса размеров jemalloc/mimalloc (четыре класса на каждое удвоение),
+// чтобы байты, которые аллокатор все равно выдаст, стали емкостью вектора
+template <typename BaseGrowth = DoublingGrowth>
+struct SizeClassGrowth {
+    static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept {
+        const size_t bytes = BaseGrowth::NextCapacity(capacity, required, element_size) * element_size;
+        return RoundUpToSizeClass(bytes) / element_size;
+    }
+
+    static size_t RoundUpToSizeClass(size_t bytes) noexcept {
+        if (bytes <= 8) {
+            return 8;
+        }
+        size_t lg_floor = 0;
+        for (size_t x = bytes - 1; x > 1; x >>= 1) {
+            ++lg_floor;
+        }
+        const size_t spacing = std::max<size_t>(size_t{1} << (lg_floor - 2), 16);
+        return (bytes + spacing - 1) / spacing * spacing;
+    }
+};
+
+// Стратегия роста с автоматическим возвратом памяти: когда после удаления элементов размер становится
+// меньше capacity / ShrinkDivisor, емкость уменьшается до удвоенного размера. Зазор между порогами
+// не дает чередованию вставок и удалений вызывать реаллокацию на каждой операции
+template <typename BaseGrowth = DoublingGrowth, size_t ShrinkDivisor = 4>
+struct AutoShrinkGrowth : BaseGrowth {
+    static_assert(ShrinkDivisor > 2, "Shrink threshold must be below the shrunk capacity");
+
+    static size_t ShrinkCapacity(size_t capacity, size_t size, size_t /*element_size*/) noexcept {
+        return size < capacity / ShrinkDivisor ? size * 2 : capacity;
+    }
+};
+
+namespace detail {
+
+template <typename GrowthPolicy, typename = void>
+struct HasShrinkCapacity : std::false_type {};
+
+template <typename GrowthPolicy>
+struct HasShrinkCapacity<GrowthPolicy, std::void_t<decltype(GrowthPolicy::ShrinkCapacity(size_t{}, size_t{}, size_t{}))>> 
+    : std::true_type {};
+
+}  // namespace detail
+
+// Политика сбора статистики, которая ничего не делает: вызовы ее функций исчезают при компиляции.
+// Собирающая политика VectorStats находится в vector_stats.h
+struct NoVectorStats {
+    static constexpr void OnAllocate(size_t /*capacity*/, size_t /*old_capacity*/, size_t /*element_size*/) noexcept {}
+    static constexpr void OnReallocateInPlace(size_t /*capacity*/, size_t /*old_capacity*/, size_t /*element_size*/) noexcept {}
+    static constexpr void OnRelocate(size_t /*count*/, RelocationKind /*kind*/) noexcept {}
+    static constexpr void OnDestroy(size_t /*capacity*/, size_t /*size*/, size_t /*element_size*/) noexcept {}
+};
+
+// Метка конструктора и Resize, создающих элементы инициализацией по умолчанию:
+// тривиальные типы при этом остаются неинициализированными
+struct DefaultInit {
+    explicit DefaultInit() = default;
+};
+inline constexpr DefaultInit DEFAULT_INIT{};
+
+// Метка перегрузок, которые создают, копируют и уничтожают элементы кусками в нескольких потоках.
+// num_threads == 0 означает число ядер. Небольшие диапазоны обрабатываются в текущем потоке
+struct ParallelPolicy {
+    size_t num_threads = 0;
+};
+inline constexpr ParallelPolicy PARALLEL{};
+
+// Буфер, который Vector::Release отдал вызывающему: size созданных элементов в памяти на capacity
+// элементов. Элементы уничтожает и память освобождает новый владелец
 template <typename T>
+struct VectorBuffer {
+    T* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth, 
+          typename Stats = NoVectorStats>
 class Vector {
+    using AllocTraits = std::allocator_traits<Allocator>;
+
 public:
 
+    using value_type = T;
+    using allocator_type = Allocator;
     using iterator = T*;
     using const_iterator = const T*;
     
-    iterator begin() noexcept { return data_.GetAddress(); }
-    iterator end() noexcept { return size_ + data_.GetAddress(); }
-    const_iterator cbegin() const noexcept { return data_.GetAddress(); }
-    const_iterator cend() const noexcept { return size_ + data_.GetAddress(); }    
-    const_iterator begin() const noexcept { return cbegin(); }
-    const_iterator end() const noexcept { return cend(); }
+    // Выравнивание начала буфера, которое гарантирует аллокатор
+    static constexpr size_t ALIGNMENT = detail::AllocatorAlignment<Allocator>::value;
+
+    VECTOR_CONSTEXPR iterator begin() noexcept { return Data(); }
+    VECTOR_CONSTEXPR iterator end() noexcept { return size_ + data_.GetAddress(); }
+    VECTOR_CONSTEXPR const_iterator cbegin() const noexcept { return Data(); }
+    VECTOR_CONSTEXPR const_iterator cend() const noexcept { return size_ + data_.GetAddress(); }    
+    VECTOR_CONSTEXPR const_iterator begin() const noexcept { return cbegin(); }
+    VECTOR_CONSTEXPR const_iterator end() const noexcept { return cend(); }
+
+    VECTOR_CONSTEXPR T* Data() noexcept { return detail::AssumeAligned<ALIGNMENT>(data_.GetAddress()); }
+    VECTOR_CONSTEXPR const T* Data() const noexcept { return detail::AssumeAligned<ALIGNMENT>(data_.GetAddress()); }
+    VECTOR_CONSTEXPR T* data() noexcept { return Data(); }
+    VECTOR_CONSTEXPR const T* data() const noexcept { return Data(); }
     
-    Vector() = default;
+    VECTOR_CONSTEXPR Vector() = default;
+
+    VECTOR_CONSTEXPR explicit Vector(const Allocator& alloc) noexcept 
+        : data_(alloc) {}
     
-    explicit Vector(size_t size) 
-        : data_(size)
+    VECTOR_CONSTEXPR explicit Vector(size_t size, const Allocator& alloc = Allocator()) 
+        : data_(size, alloc)
         , size_(size) {
-        std::uninitialized_value_construct_n(begin(), size);
+        detail::UninitializedValueConstructN(begin(), size);
+        Stats::OnAllocate(Capacity(), 0, sizeof(T));
+    }
+
+    Vector(size_t size, DefaultInit, const Allocator& alloc = Allocator()) 
+        : data_(size, alloc)
+        , size_(size) {
+        std::uninitialized_default_construct_n(begin(), size);
+        Stats::OnAllocate(Capacity(), 0, sizeof(T));
+    }
+    
+    // Перегрузки с ParallelPolicy дают те же гарантии безопасности исключений, что и последовательные
+    Vector(size_t size, ParallelPolicy policy, const Allocator& alloc = Allocator())
+        : data_(size, alloc)
+        , size_(size) {
+        detail::ParallelUninitializedConstruct(begin(), size, ChunkCount(size, policy), [this](size_t offset, size_t n) {
+            std::uninitialized_value_construct_n(begin() + offset, n);
+        });
+        Stats::OnAllocate(Capacity(), 0, sizeof(T));
+    }
+
+    template <typename InputIt, typename = detail::EnableIfIteratorCategory<InputIt, std::input_iterator_tag>>
+    Vector(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+        : data_(alloc) {
+        if constexpr (detail::IsForwardIterator<InputIt>::value) {
+            const size_t count = std::distance(first, last);
+            RawMemory<T, Allocator> new_data = AllocateStorage(count);
+            std::uninitialized_copy(first, last, new_data.GetAddress());
+            data_.Swap(new_data);
+            size_ = count;
+        } else {
+            Append(first, last);
+        }
     }
     
     Vector(const Vector& other)
-        : data_(other.size_)
+        : Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {}
+
+    Vector(const Vector& other, const Allocator& alloc)
+        : data_(other.size_, alloc)
         , size_(other.size_) {
         std::uninitialized_copy_n(other.data_.GetAddress(), size_, begin());
+        Stats::OnAllocate(Capacity(), 0, sizeof(T));
     }
     
-    Vector(Vector&& other) noexcept 
+    Vector(const Vector& other, ParallelPolicy policy)
+        : Vector(other, policy, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {}
+
+    Vector(const Vector& other, ParallelPolicy policy, const Allocator& alloc)
+        : data_(other.size_, alloc)
+        , size_(other.size_) {
+        const T* src = other.data_.GetAddress();
+        detail::ParallelUninitializedConstruct(begin(), size_, ChunkCount(size_, policy), [this, src](size_t offset, size_t n) {
+            std::uninitialized_copy_n(src + offset, n, begin() + offset);
+        });
+        Stats::OnAllocate(Capacity(), 0, sizeof(T));
+    }
+
+    VECTOR_CONSTEXPR Vector(Vector&& other) noexcept 
         : data_(std::move(other.data_))
         , size_(std::exchange(other.size_, 0)) {}
         
     void CopyNotSwap(const Vector& src) {
-        const T* src_begin = src.data_.GetAddress();
-        std::copy(src_begin, src_begin + std::min(size_, src.size_), begin());
+        AssignNotSwap(src.data_.GetAddress(), src.size_);
+    }
+
+    void CopyNotSwap(const Vector& src, ParallelPolicy policy) {
+        const T* src_data = src.data_.GetAddress();
+        const size_t common = std::min(size_, src.size_);
+        detail::ForEachChunk(common, ChunkCount(common, policy), [this, src_data](size_t offset, size_t n) {
+            std::copy_n(src_data + offset, n, begin() + offset);
+        });
         if (size_ <= src.size_) {
-            std::uninitialized_copy_n(src_begin + size_, src.size_ - size_, end());
-        } 
+            const size_t count = src.size_ - size_;
+            detail::ParallelUninitializedConstruct(end(), count, ChunkCount(count, policy),
+                                                   [this, src_data](size_t offset, size_t n) {
+                std::uninitialized_copy_n(src_data + size_ + offset, n, end() + offset);
+            });
+        }
         else {
-            std::destroy_n(begin() + src.size_, size_ - src.size_);
+            detail::ParallelDestroyN(begin() + src.size_, size_ - src.size_, ChunkCount(size_ - src.size_, policy));
         }
-        size_ = src.size_;        
+        size_ = src.size_;
     }
         
     Vector& operator=(const Vector& other) {
         if (this == &other) return *this;
+        if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+            if (GetAllocator() != other.GetAllocator()) {
+                // Текущий буфер нельзя переиспользовать: он должен быть освобожден своим аллокатором
+                RawMemory<T, Allocator> new_data(other.size_, other.GetAllocator());
+                Stats::OnAllocate(other.size_, Capacity(), sizeof(T));
+                std::uninitialized_copy_n(other.data_.GetAddress(), other.size_, new_data.GetAddress());
+                std::destroy_n(begin(), size_);
+                data_.Swap(new_data);
+                size_ = other.size_;
+                return *this;
+            }
+        }
         if (other.size_ <= Capacity()) {
             CopyNotSwap(other);
         } 
         else {              
-            Vector other_copy(other);
+            Vector other_copy(other, GetAllocator());
             Swap(other_copy);
         }
         return *this;
     }
     
-    Vector& operator=(Vector&& other) noexcept {
-        if(this != &other) {    
-            Swap(other);
+    Vector& operator=(Vector&& other) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                               || AllocTraits::is_always_equal::value) {
+        if (this == &other) return *this;
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value 
+                      || AllocTraits::is_always_equal::value) {
+            data_.Swap(other.data_), std::swap(size_, other.size_);
+        } 
+        else if (GetAllocator() == other.GetAllocator()) {
+            data_.Swap(other.data_), std::swap(size_, other.size_);
+        } 
+        else if (other.size_ <= Capacity()) {
+            // Чужой буфер забрать нельзя, поэтому элементы перемещаются по одному
+            AssignNotSwap(std::make_move_iterator(other.begin()), other.size_);
+        } 
+        else {
+            Vector other_copy(GetAllocator());
+            other_copy.Reserve(other.size_);
+            std::uninitialized_move_n(other.begin(), other.size_, other_copy.begin());
+            other_copy.size_ = other.size_;
+            Swap(other_copy);
         }
         return *this;
     }
 
-    void Reserve(size_t new_capacity) {
+    VECTOR_CONSTEXPR void Reserve(size_t new_capacity) {
         if (new_capacity <= Capacity()) { return; }
-        RawMemory<T> new_data(new_capacity);
-        T* new_begin = new_data.GetAddress();
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(begin(), size_, new_begin);
-        } else {
-            std::uninitialized_copy_n(begin(), size_, new_begin);
-        }
-        data_.Swap(new_data);
-        std::destroy_n(new_begin, size_);
+        ReallocateStorage(new_capacity);
+    }
+
+    void Reserve(size_t new_capacity, ParallelPolicy policy) {
+        if (new_capacity <= Capacity()) { return; }
+        ReallocateStorage(new_capacity, ChunkCount(size_, policy));
     }
     
-    void Resize(size_t new_size) {
-        new_size < size_ ? (void)(std::destroy_n(begin() + new_size, size_ - new_size)) : void();
-        if (new_size > size_) { 
-            new_size > data_.Capacity() ? (void)(Reserve(std::max(data_.Capacity() * 2, new_size))) : void();
-            std::uninitialized_value_construct_n(end(), new_size - size_);
+    VECTOR_CONSTEXPR void Resize(size_t new_size) {
+        if (new_size < size_) {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+            size_ = new_size;
+            MaybeShrink();
+            return;
+        }
+        new_size > data_.Capacity() ? (void)(Reserve(NextCapacity(new_size))) : void();
+        detail::UninitializedValueConstructN(end(), new_size - size_);
+        size_ = new_size;
+    }
+
+    void ResizeDefaultInit(size_t new_size) {
+        if (new_size < size_) {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+            size_ = new_size;
+            MaybeShrink();
+            return;
         }
+        new_size > data_.Capacity() ? (void)(Reserve(NextCapacity(new_size))) : void();
+        std::uninitialized_default_construct_n(end(), new_size - size_);
+        size_ = new_size;
+    }
+
+    // Уменьшает емкость до размера. Если перенос элементов бросит исключение, вектор не изменится
+    void ShrinkToFit() {
+        if (size_ < Capacity()) {
+            ReallocateStorage(size_);
+        }
+    }
+
+    // Удаляет все элементы, сохраняя емкость
+    VECTOR_CONSTEXPR void Clear() noexcept {
+        std::destroy_n(begin(), size_);
+        size_ = 0;
+    }
+
+    void Clear(ParallelPolicy policy) noexcept {
+        detail::ParallelDestroyN(begin(), size_, ChunkCount(size_, policy));
+        size_ = 0;
+    }
+
+    // Удаляет все элементы и освобождает буфер
+    void ClearAndFree() noexcept {
+        Clear();
+        RawMemory<T, Allocator> empty(data_.GetAllocator());
+        data_.Swap(empty);
+    }
+
+    // Деструктор уничтожает элементы в одном потоке; большой вектор можно перед разрушением
+    // освободить параллельно вызовом ClearAndFree(PARALLEL)
+    void ClearAndFree(ParallelPolicy policy) noexcept {
+        Clear(policy);
+        RawMemory<T, Allocator> empty(data_.GetAllocator());
+        data_.Swap(empty);
+    }
+
+    // Как std::string::resize_and_overwrite: op(data, count) заполняет первые элементы буфера
+    // размером count, значения которых не определены, и возвращает новый размер не больше count.
+    // Тривиально копируемые элементы op может записать побайтово, например прочитав их из файла
+    template <typename Operation>
+    void ResizeAndOverwrite(size_t count, Operation op) {
+        static_assert((std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>)
+                      || std::is_trivially_copyable_v<T>,
+                      "ResizeAndOverwrite requires trivial elements");
+        if (count > Capacity()) {
+            Reserve(NextCapacity(count));
+        }
+        const size_t new_size = std::move(op)(begin(), count);
+        assert(new_size <= count);
         size_ = new_size;
     }
     
-    void PopBack() {
+    VECTOR_CONSTEXPR void PopBack() {
         assert(size_);
         std::destroy_at(begin() + --size_);
+        MaybeShrink();
     }    
     
     template <typename... Args>
-    T& EmplaceBack(Args&&... args) {
+    VECTOR_CONSTEXPR T& EmplaceBack(Args&&... args) {
+        if constexpr (REALLOCATE_IN_PLACE) {
+            if (size_ == Capacity()) {
+                // Аргументы могут ссылаться на элементы, которые realloc перенесет
+                T t(std::forward<Args>(args)...);
+                ReallocateStorage(NextCapacity(size_ + 1));
+                return EmplaceBack(std::move(t));
+            }
+        }
         if (size_ < Capacity()) {
-            new (data_.GetAddress() + size_) T(std::forward<Args>(args)...);
+            detail::ConstructAt(data_.GetAddress() + size_, std::forward<Args>(args)...);
             ++size_;
             return data_[size_-1];
         }
-        RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-        T* new_begin = new_data.GetAddress();
-        new (new_begin + size_) T(std::forward<Args>(args)...);
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(begin(), size_, new_begin);
-        } 
-        else {
-            std::uninitialized_copy_n(begin(), size_, new_begin);
-        }
-        std::destroy_n(begin(), size_++);
-        data_.Swap(new_data);
-        return data_[size_-1];
+        RawMemory<T, Allocator> new_data = AllocateStorage(NextCapacity(size_ + 1));
+        detail::UninitializedRelocateAndEmplace(begin(), size_, new_data.GetAddress(), size_, std::forward<Args>(args)...);
+        ReplaceStorage(new_data);
+        return data_[size_++];
     }
     
     template <typename S>
-    void PushBack(S&& value) {
+    VECTOR_CONSTEXPR void PushBack(S&& value) {
         EmplaceBack(std::forward<S>(value));
     }
     
     template <typename... Args>
     iterator Emplace(const_iterator pos, Args&&... args) {
-        if (pos < begin() && pos > end()) return nullptr;
-        int new_pos = pos - begin(); 
-        if (size_ < data_.Capacity()) {
-            T t(std::forward<Args>(args)...);
-            if (pos != end()) {
-                new (end()) T(std::forward<T>(data_[size_- 1])); 
-                std::move_backward(begin() + new_pos, end() - 1, end());
+        assert(pos >= begin() && pos <= end());
+        const size_t new_pos = pos - begin();
+        if constexpr (REALLOCATE_IN_PLACE) {
+            if (size_ == Capacity()) {
+                T t(std::forward<Args>(args)...);
+                ReallocateStorage(NextCapacity(size_ + 1));
+                return Emplace(begin() + new_pos, std::move(t));
             }
-            *(begin() + new_pos) = std::forward<T>(t);
+        }
+        if (size_ < data_.Capacity()) {
+            detail::EmplaceInCapacity(begin(), size_, new_pos, std::forward<Args>(args)...);
             ++size_;
             return begin() + new_pos;
         }
-        RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-        T* new_begin = new_data.GetAddress();
-        new (new_begin + new_pos) T(std::forward<Args>(args)...);
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(begin(), new_pos, new_begin);
-            std::uninitialized_move_n(begin() + new_pos, size_ - new_pos, new_begin + new_pos + 1);
-        } 
-        else {
-            std::uninitialized_copy_n(begin(), new_pos - 1, new_begin);
-            std::uninitialized_copy_n(begin() + new_pos, size_ - new_pos, new_begin + new_pos + 1);
-        }
-        std::destroy_n(begin(), size_++);
-        data_.Swap(new_data);
+        RawMemory<T, Allocator> new_data = AllocateStorage(NextCapacity(size_ + 1));
+        detail::UninitializedRelocateAndEmplace(begin(), size_, new_data.GetAddress(), new_pos, std::forward<Args>(args)...);
+        ReplaceStorage(new_data);
+        ++size_;
         return begin() + new_pos;
     }
     
     iterator Erase(const_iterator pos) {
-        if (pos < begin() && pos >= end()) return nullptr;
-        int new_pos = pos - begin();
-        std::move(begin() + new_pos + 1, end(), begin() + new_pos);
-        std::destroy_at(end() - 1);
+        assert(pos >= begin() && pos < end());
+        const size_t new_pos = pos - begin();
+        detail::EraseAt(begin(), size_, new_pos);
         --size_;
+        MaybeShrink();
+        return begin() + new_pos;
+    }
+    
+    iterator Erase(const_iterator first, const_iterator last) {
+        assert(first >= begin() && first <= last && last <= end());
+        const size_t new_pos = first - begin();
+        if (first != last) {
+            detail::EraseRange(begin(), size_, new_pos, last - first);
+            size_ -= last - first;
+            MaybeShrink();
+        }
+        return begin() + new_pos;
+    }
+
+    // Удаляет элемент за O(1), перемещая на его место последний элемент; порядок элементов не сохраняется
+    iterator SwapErase(const_iterator pos) {
+        assert(pos >= begin() && pos < end());
+        const size_t new_pos = pos - begin();
+        if (new_pos != size_ - 1) {
+            data_[new_pos] = std::move(data_[size_ - 1]);
+        }
+        PopBack();
         return begin() + new_pos;
     }
     
@@ -214,32 +1053,304 @@ public:
         return Emplace(pos, std::move(value));
     }  
 
+    iterator Insert(const_iterator pos, size_t count, const T& value) {
+        assert(pos >= begin() && pos <= end());
+        const size_t new_pos = pos - begin();
+        if (&value >= begin() && &value < end() && size_ + count <= Capacity()) {
+            // Сдвиг хвоста затронет value, поэтому вставляется его копия
+            T value_copy(value);
+            return InsertForwardRange(new_pos, detail::RepeatIterator<T>(value_copy, 0), count);
+        }
+        return InsertForwardRange(new_pos, detail::RepeatIterator<T>(value, 0), count);
+    }
+
+    // Для однопроходных итераторов элементы добавляются в конец и затем поворачиваются на место,
+    // для остальных размер вычисляется заранее, так что реаллокация и сдвиг хвоста происходят один раз
+    template <typename InputIt, typename = detail::EnableIfIteratorCategory<InputIt, std::input_iterator_tag>>
+    iterator Insert(const_iterator pos, InputIt first, InputIt last) {
+        assert(pos >= begin() && pos <= end());
+        const size_t new_pos = pos - begin();
+        if constexpr (detail::IsForwardIterator<InputIt>::value) {
+            const size_t count = std::distance(first, last);
+            if constexpr (std::is_pointer_v<InputIt>) {
+                if (count != 0 && &*first >= begin() && &*first < end() && size_ + count <= Capacity()) {
+                    Vector range_copy(first, last, GetAllocator());
+                    return InsertForwardRange(new_pos, std::make_move_iterator(range_copy.begin()), count);
+                }
+            }
+            return InsertForwardRange(new_pos, first, count);
+        } else {
+            const size_t old_size = size_;
+            for (; first != last; ++first) {
+                EmplaceBack(*first);
+            }
+            std::rotate(begin() + new_pos, begin() + old_size, end());
+            return begin() + new_pos;
+        }
+    }
+
+    template <typename InputIt, typename = detail::EnableIfIteratorCategory<InputIt, std::input_iterator_tag>>
+    void Append(InputIt first, InputIt last) {
+        Insert(end(), first, last);
+    }
+
+    // Переносит в конец вектора элементы всех векторов из [first, last), выделяя память один раз под
+    // итоговый размер. Части переносятся в свои диапазоны параллельно, после чего части
+    // становятся пустыми, сохраняя емкость. Если перенос бросит исключение, вектор и части не изменятся
+    template <typename ForwardIt, typename = detail::EnableIfIteratorCategory<ForwardIt, std::forward_iterator_tag>>
+    void ParallelAppend(ForwardIt first, ForwardIt last) {
+        struct Part {
+            Vector* source;
+            T* dest;
+            std::exception_ptr error;
+        };
+        Vector<Part> parts;
+        parts.Reserve(std::distance(first, last));
+        size_t new_size = size_;
+        for (; first != last; ++first) {
+            Vector& source = *first;
+            assert(&source != this);
+            parts.PushBack(Part{&source, nullptr, nullptr});
+            new_size += source.size_;
+        }
+        Reserve(new_size);
+        T* dest = end();
+        for (Part& part : parts) {
+            part.dest = dest;
+            dest += part.source->size_;
+        }
+
+        // Без NOTHROW_RELOCATE элементы сначала копируются, а исходные уничтожаются только после того,
+        // как скопированы все части
+        const auto relocate = [&parts](size_t i) noexcept {
+            Part& part = parts[i];
+            if constexpr (NOTHROW_RELOCATE) {
+                detail::UninitializedRelocateN(part.source->begin(), part.source->size_, part.dest);
+            } else {
+                try {
+                    std::uninitialized_copy_n(detail::MakeMoveIfNoexceptIterator(part.source->begin()),
+                                              part.source->size_, part.dest);
+                } catch (...) {
+                    part.error = std::current_exception();
+                }
+            }
+        };
+        if ((new_size - size_) * sizeof(T) >= detail::PARALLEL_MIN_BYTES) {
+            // Потоков не больше, чем ядер: каждый переносит свою группу соседних частей
+            const size_t workers = std::min<size_t>(parts.Size(), std::max(std::thread::hardware_concurrency(), 1u));
+            detail::RunInParallel(workers, [&parts, &relocate, workers](size_t worker) noexcept {
+                const auto [first_part, last_part] = detail::ChunkBounds(parts.Size(), workers, worker);
+                for (size_t i = first_part; i < last_part; ++i) {
+                    relocate(i);
+                }
+            });
+        } else {
+            for (size_t i = 0; i < parts.Size(); ++i) {
+                relocate(i);
+            }
+        }
+
+        if constexpr (!NOTHROW_RELOCATE) {
+            const auto failed = std::find_if(parts.begin(), parts.end(), [](const Part& part) {
+                return part.error != nullptr;
+            });
+            if (failed != parts.end()) {
+                for (Part& part : parts) {
+                    if (!part.error) {
+                        std::destroy_n(part.dest, part.source->size_);
+                    }
+                }
+                std::rethrow_exception(failed->error);
+            }
+            for (Part& part : parts) {
+                std::destroy_n(part.source->begin(), part.source->size_);
+            }
+        }
+        for (Part& part : parts) {
+            part.source->size_ = 0;
+        }
+        Stats::OnRelocate(new_size - size_, detail::RelocationKindOf<T>());
+        size_ = new_size;
+    }
+
+    // Уничтожает текущие элементы и принимает владение буфером data на capacity элементов, в начале
+    // которого созданы size элементов. Буфер должен быть выделен аллокатором, равным alloc: например,
+    // для MallocAllocator подходит любой буфер из malloc, полученный от C-библиотеки без копирования
+    void Adopt(T* data, size_t size, size_t capacity, const Allocator& alloc) noexcept {
+        assert(size <= capacity);
+        std::destroy_n(begin(), size_);
+        size_ = 0;
+        RawMemory<T, Allocator> adopted = RawMemory<T, Allocator>::Adopt(data, capacity, alloc);
+        data_.Swap(adopted);
+        size_ = size;
+    }
+
+    void Adopt(T* data, size_t size, size_t capacity) noexcept {
+        Adopt(data, size, capacity, GetAllocator());
+    }
+
+    // Отдает буфер вместе с элементами без копирования и оставляет вектор пустым
+    VectorBuffer<T> Release() noexcept {
+        const VectorBuffer<T> buffer{data_.GetAddress(), size_, data_.Capacity()};
+        data_.Release();
+        size_ = 0;
+        return buffer;
+    }
+
     void Swap(Vector& other) noexcept {
+        if constexpr (!AllocTraits::propagate_on_container_swap::value) {
+            assert(GetAllocator() == other.GetAllocator());
+        }
         data_.Swap(other.data_), std::swap(size_, other.size_);
     }
     
-    size_t Size() const noexcept {
+    VECTOR_CONSTEXPR size_t Size() const noexcept {
         return size_;
     }
 
-    size_t Capacity() const noexcept {
+    VECTOR_CONSTEXPR size_t Capacity() const noexcept {
         return data_.Capacity();
     }
 
-    const T& operator[](size_t index) const noexcept {
+    VECTOR_CONSTEXPR Allocator GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
+    VECTOR_CONSTEXPR const T& operator[](size_t index) const noexcept {
         return const_cast<Vector&>(*this)[index];
     }
 
-    T& operator[](size_t index) noexcept {
+    VECTOR_CONSTEXPR T& operator[](size_t index) noexcept {
         assert(index < size_);
         return data_[index];
     }
     
-    ~Vector() {
+    VECTOR_CONSTEXPR ~Vector() {
+        Stats::OnDestroy(Capacity(), size_, sizeof(T));
         std::destroy_n(data_.GetAddress(), size_);;
     }
 
 private:
-    RawMemory<T>  data_;
+    static constexpr bool REALLOCATE_IN_PLACE = IsTriviallyRelocatable<T>::value 
+                                                && detail::HasReallocate<Allocator>::value;
+    static constexpr bool NOTHROW_RELOCATE = IsTriviallyRelocatable<T>::value
+                                             || std::is_nothrow_move_constructible_v<T>;
+
+    RawMemory<T, Allocator> data_;
     size_t size_ = 0;
+
+    VECTOR_CONSTEXPR size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::NextCapacity(Capacity(), required, sizeof(T));
+    }
+
+    static size_t ChunkCount(size_t count, ParallelPolicy policy) noexcept {
+        return detail::ParallelChunkCount(count, sizeof(T), policy.num_threads);
+    }
+
+    // Вставляет count элементов из first перед позицией pos, реаллоцируя память не более одного раза.
+    // Диапазон не должен ссылаться на элементы вектора, если реаллокация не нужна
+    template <typename ForwardIt>
+    iterator InsertForwardRange(size_t pos, ForwardIt first, size_t count) {
+        if (count == 0) return begin() + pos;
+        if (size_ + count > Capacity()) {
+            RawMemory<T, Allocator> new_data = AllocateStorage(NextCapacity(size_ + count));
+            T* new_begin = new_data.GetAddress();
+            std::uninitialized_copy_n(first, count, new_begin + pos);
+            try {
+                detail::UninitializedRelocateWithGap(begin(), size_, new_begin, pos, count);
+            } catch (...) {
+                std::destroy_n(new_begin + pos, count);
+                throw;
+            }
+            ReplaceStorage(new_data);
+            size_ += count;
+            return begin() + pos;
+        }
+        T* hole = begin() + pos;
+        const size_t tail = size_ - pos;
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            detail::MemmoveN(hole + count, hole, tail);
+            std::uninitialized_copy_n(first, count, hole);
+            size_ += count;
+        } else if (count <= tail) {
+            T* old_end = end();
+            std::uninitialized_move(old_end - count, old_end, old_end);
+            size_ += count;
+            std::move_backward(hole, old_end - count, old_end);
+            std::copy_n(first, count, hole);
+        } else {
+            T* old_end = end();
+            ForwardIt mid = std::next(first, tail);
+            std::uninitialized_copy_n(mid, count - tail, old_end);
+            size_ += count - tail;
+            std::uninitialized_move(hole, old_end, hole + count);
+            size_ += tail;
+            std::copy_n(first, tail, hole);
+        }
+        return begin() + pos;
+    }
+
+    // Возврат памяти необязателен, поэтому неудачная реаллокация оставляет прежний буфер
+    VECTOR_CONSTEXPR void MaybeShrink() noexcept {
+        if constexpr (detail::HasShrinkCapacity<GrowthPolicy>::value) {
+            const size_t new_capacity = GrowthPolicy::ShrinkCapacity(Capacity(), size_, sizeof(T));
+            if (new_capacity < Capacity()) {
+                try {
+                    ReallocateStorage(new_capacity);
+                } catch (...) {
+                }
+            }
+        }
+    }
+
+    VECTOR_CONSTEXPR RawMemory<T, Allocator> AllocateStorage(size_t capacity) {
+        RawMemory<T, Allocator> new_data(capacity, data_.GetAllocator());
+        Stats::OnAllocate(capacity, Capacity(), sizeof(T));
+        return new_data;
+    }
+
+    // Делает new_data текущим буфером после того, как в него перенесены все size_ элементов
+    VECTOR_CONSTEXPR void ReplaceStorage(RawMemory<T, Allocator>& new_data) noexcept {
+        data_.Swap(new_data);
+        Stats::OnRelocate(size_, detail::RelocationKindOf<T>());
+    }
+
+    VECTOR_CONSTEXPR void ReallocateStorage(size_t new_capacity, size_t chunks = 1) {
+        if constexpr (REALLOCATE_IN_PLACE) {
+            const size_t old_capacity = Capacity();
+            if (!detail::IsConstantEvaluated() && data_.TryReallocate(new_capacity)) {
+                Stats::OnReallocateInPlace(new_capacity, old_capacity, sizeof(T));
+                return;
+            }
+        }
+        RawMemory<T, Allocator> new_data = AllocateStorage(new_capacity);
+        if (detail::IsConstantEvaluated()) {
+            detail::UninitializedRelocateN(begin(), size_, new_data.GetAddress());
+        } else {
+            detail::ParallelUninitializedRelocateN(begin(), size_, new_data.GetAddress(), chunks);
+        }
+        ReplaceStorage(new_data);
+    }
+
+    template <typename InputIt>
+    void AssignNotSwap(InputIt src_begin, size_t src_size) {
+        std::copy_n(src_begin, std::min(size_, src_size), begin());
+        if (size_ <= src_size) {
+            std::uninitialized_copy_n(std::next(src_begin, size_), src_size - size_, end());
+        } 
+        else {
+            std::destroy_n(begin() + src_size, size_ - src_size);
+        }
+        size_ = src_size;        
+    }
 };
+
+// Удаляет все элементы, удовлетворяющие pred, за один проход с сохранением порядка остальных.
+// Возвращает количество удаленных элементов
+template <typename T, typename Allocator, typename GrowthPolicy, typename Stats, typename Predicate>
+size_t EraseIf(Vector<T, Allocator, GrowthPolicy, Stats>& vector, Predicate pred) {
+    const auto new_end = std::remove_if(vector.begin(), vector.end(), pred);
+    const size_t count = vector.end() - new_end;
+    vector.Erase(new_end, vector.end());
+    return count;
+}
@@ -0,0 +1,558 @@
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VECTOR_SIMD_X86 1
+#define VECTOR_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define VECTOR_TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define VECTOR_SIMD_NEON 1
+#endif
+
+#include "vector.h"
+
+// Набор инструкций, которым выполняются алгоритмы этого файла. NEON есть на любом aarch64,
+// поддержка AVX2 и AVX-512 проверяется при первом вызове
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512,
+    NEON,
+};
+
+inline bool IsSupported(SimdLevel level) noexcept {
+    switch (level) {
+    case SimdLevel::SCALAR:
+        return true;
+#if defined(VECTOR_SIMD_X86)
+    case SimdLevel::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case SimdLevel::AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+#elif defined(VECTOR_SIMD_NEON)
+    case SimdLevel::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Лучший поддерживаемый процессором набор инструкций
+inline SimdLevel DetectSimdLevel() noexcept {
+    static const SimdLevel level = IsSupported(SimdLevel::AVX512) ? SimdLevel::AVX512
+                                 : IsSupported(SimdLevel::AVX2)   ? SimdLevel::AVX2
+                                 : IsSupported(SimdLevel::NEON)   ? SimdLevel::NEON
+                                                                  : SimdLevel::SCALAR;
+    return level;
+}
+
+// Тип суммы: целые суммируются в 64 бита, чтобы сумма миллионов элементов не переполнялась
+template <typename T>
+using SumType = std::conditional_t<std::is_floating_point_v<T>, T,
+                                   std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+namespace detail {
+
+template <typename T>
+struct TypeIdentity {
+    using type = T;
+};
+
+template <typename T>
+using NonDeduced = typename TypeIdentity<T>::type;
+
+template <typename Container>
+using EnableIfContiguous = std::enable_if_t<std::is_pointer_v<decltype(std::declval<Container&>().begin())>>;
+
+// Векторные ядра есть только для 32-битных элементов, остальные типы обрабатываются скалярно
+template <typename T>
+inline constexpr bool HAS_SIMD_KERNELS = std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t>
+                                         || std::is_same_v<T, float>;
+
+template <typename T>
+const T* FindScalar(const T* first, const T* last, T value) noexcept {
+    for (; first != last; ++first) {
+        if (*first == value) {
+            return first;
+        }
+    }
+    return last;
+}
+
+template <typename T>
+size_t CountScalar(const T* first, const T* last, T value) noexcept {
+    size_t count = 0;
+    for (; first != last; ++first) {
+        count += *first == value;
+    }
+    return count;
+}
+
+template <typename T>
+void MinMaxScalar(const T* first, const T* last, T& min, T& max) noexcept {
+    for (; first != last; ++first) {
+        min = *first < min ? *first : min;
+        max = max < *first ? *first : max;
+    }
+}
+
+template <typename T>
+SumType<T> SumScalar(const T* first, const T* last) noexcept {
+    SumType<T> sum = 0;
+    for (; first != last; ++first) {
+        sum += *first;
+    }
+    return sum;
+}
+
+#if defined(VECTOR_SIMD_X86)
+
+template <typename T>
+VECTOR_TARGET_AVX2 unsigned EqualMaskAvx2(const T* p, T value) noexcept {
+    if constexpr (std::is_same_v<T, float>) {
+        return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p), _mm256_set1_ps(value), _CMP_EQ_OQ));
+    } else {
+        const __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+                                                 _mm256_set1_epi32(static_cast<int32_t>(value)));
+        return _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+    }
+}
+
+template <typename T>
+VECTOR_TARGET_AVX2 const T* FindAvx2(const T* first, const T* last, T value) noexcept {
+    for (; last - first >= 8; first += 8) {
+        if (const unsigned mask = EqualMaskAvx2(first, value); mask != 0) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+    return FindScalar(first, last, value);
+}
+
+template <typename T>
+VECTOR_TARGET_AVX2 size_t CountAvx2(const T* first, const T* last, T value) noexcept {
+    size_t count = 0;
+    for (; last - first >= 8; first += 8) {
+        count += __builtin_popcount(EqualMaskAvx2(first, value));
+    }
+    return count + CountScalar(first, last, value);
+}
+
+template <typename T>
+VECTOR_TARGET_AVX2 void MinMaxAvx2(const T* first, const T* last, T& min, T& max) noexcept {
+    if (last - first >= 8) {
+        alignas(32) T lanes_min[8];
+        alignas(32) T lanes_max[8];
+        if constexpr (std::is_same_v<T, float>) {
+            __m256 vmin = _mm256_set1_ps(min);
+            __m256 vmax = _mm256_set1_ps(max);
+            for (; last - first >= 8; first += 8) {
+                const __m256 x = _mm256_loadu_ps(first);
+                vmin = _mm256_min_ps(x, vmin);
+                vmax = _mm256_max_ps(x, vmax);
+            }
+            _mm256_store_ps(lanes_min, vmin);
+            _mm256_store_ps(lanes_max, vmax);
+        } else {
+            __m256i vmin = _mm256_set1_epi32(static_cast<int32_t>(min));
+            __m256i vmax = _mm256_set1_epi32(static_cast<int32_t>(max));
+            for (; last - first >= 8; first += 8) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                if constexpr (std::is_signed_v<T>) {
+                    vmin = _mm256_min_epi32(x, vmin);
+                    vmax = _mm256_max_epi32(x, vmax);
+                } else {
+                    vmin = _mm256_min_epu32(x, vmin);
+                    vmax = _mm256_max_epu32(x, vmax);
+                }
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_min), vmin);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_max), vmax);
+        }
+        MinMaxScalar(lanes_min, lanes_min + 8, min, max);
+        MinMaxScalar(lanes_max, lanes_max + 8, min, max);
+    }
+    MinMaxScalar(first, last, min, max);
+}
+
+template <typename T>
+VECTOR_TARGET_AVX2 SumType<T> SumAvx2(const T* first, const T* last) noexcept {
+    SumType<T> sum = 0;
+    if constexpr (std::is_same_v<T, float>) {
+        // Два накопителя не дают задержке сложения ограничить пропускную способность
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; last - first >= 16; first += 16) {
+            acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(first));
+            acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(first + 8));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, _mm256_add_ps(acc0, acc1));
+        sum = SumScalar(lanes, lanes + 8);
+    } else {
+        __m256i acc = _mm256_setzero_si256();
+        for (; last - first >= 4; first += 4) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            acc = _mm256_add_epi64(acc, std::is_signed_v<T> ? _mm256_cvtepi32_epi64(x) : _mm256_cvtepu32_epi64(x));
+        }
+        alignas(32) SumType<T> lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return sum + SumScalar(first, last);
+}
+
+// Заглушки _mm512_undefined_* в заголовках GCC 12 без оптимизации дают ложные предупреждения
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <typename T>
+VECTOR_TARGET_AVX512 __mmask16 EqualMaskAvx512(const T* p, T value) noexcept {
+    if constexpr (std::is_same_v<T, float>) {
+        return _mm512_cmp_ps_mask(_mm512_loadu_ps(p), _mm512_set1_ps(value), _CMP_EQ_OQ);
+    } else {
+        return _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(p), _mm512_set1_epi32(static_cast<int32_t>(value)));
+    }
+}
+
+template <typename T>
+VECTOR_TARGET_AVX512 const T* FindAvx512(const T* first, const T* last, T value) noexcept {
+    for (; last - first >= 16; first += 16) {
+        if (const unsigned mask = EqualMaskAvx512(first, value); mask != 0) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+    return FindScalar(first, last, value);
+}
+
+template <typename T>
+VECTOR_TARGET_AVX512 size_t CountAvx512(const T* first, const T* last, T value) noexcept {
+    size_t count = 0;
+    for (; last - first >= 16; first += 16) {
+        count += __builtin_popcount(EqualMaskAvx512(first, value));
+    }
+    return count + CountScalar(first, last, value);
+}
+
+template <typename T>
+VECTOR_TARGET_AVX512 void MinMaxAvx512(const T* first, const T* last, T& min, T& max) noexcept {
+    if (last - first < 16) {
+        MinMaxScalar(first, last, min, max);
+        return;
+    }
+    T vector_min;
+    T vector_max;
+    if constexpr (std::is_same_v<T, float>) {
+        __m512 vmin = _mm512_set1_ps(min);
+        __m512 vmax = _mm512_set1_ps(max);
+        for (; last - first >= 16; first += 16) {
+            const __m512 x = _mm512_loadu_ps(first);
+            vmin = _mm512_min_ps(x, vmin);
+            vmax = _mm512_max_ps(x, vmax);
+        }
+        vector_min = _mm512_reduce_min_ps(vmin);
+        vector_max = _mm512_reduce_max_ps(vmax);
+    } else {
+        __m512i vmin = _mm512_set1_epi32(static_cast<int32_t>(min));
+        __m512i vmax = _mm512_set1_epi32(static_cast<int32_t>(max));
+        for (; last - first >= 16; first += 16) {
+            const __m512i x = _mm512_loadu_si512(first);
+            if constexpr (std::is_signed_v<T>) {
+                vmin = _mm512_min_epi32(x, vmin);
+                vmax = _mm512_max_epi32(x, vmax);
+            } else {
+                vmin = _mm512_min_epu32(x, vmin);
+                vmax = _mm512_max_epu32(x, vmax);
+            }
+        }
+        if constexpr (std::is_signed_v<T>) {
+            vector_min = _mm512_reduce_min_epi32(vmin);
+            vector_max = _mm512_reduce_max_epi32(vmax);
+        } else {
+            vector_min = _mm512_reduce_min_epu32(vmin);
+            vector_max = _mm512_reduce_max_epu32(vmax);
+        }
+    }
+    MinMaxScalar(&vector_min, &vector_min + 1, min, max);
+    MinMaxScalar(&vector_max, &vector_max + 1, min, max);
+    MinMaxScalar(first, last, min, max);
+}
+
+template <typename T>
+VECTOR_TARGET_AVX512 SumType<T> SumAvx512(const T* first, const T* last) noexcept {
+    SumType<T> sum = 0;
+    if constexpr (std::is_same_v<T, float>) {
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        for (; last - first >= 32; first += 32) {
+            acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(first));
+            acc1 = _mm512_add_ps(acc1, _mm512_loadu_ps(first + 16));
+        }
+        sum = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    } else {
+        __m512i acc = _mm512_setzero_si512();
+        for (; last - first >= 8; first += 8) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            acc = _mm512_add_epi64(acc, std::is_signed_v<T> ? _mm512_cvtepi32_epi64(x) : _mm512_cvtepu32_epi64(x));
+        }
+        sum = static_cast<SumType<T>>(_mm512_reduce_add_epi64(acc));
+    }
+    return sum + SumScalar(first, last);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#elif defined(VECTOR_SIMD_NEON)
+
+template <typename T>
+uint32x4_t EqualMaskNeon(const T* p, T value) noexcept {
+    if constexpr (std::is_same_v<T, float>) {
+        return vceqq_f32(vld1q_f32(p), vdupq_n_f32(value));
+    } else if constexpr (std::is_signed_v<T>) {
+        return vceqq_s32(vld1q_s32(p), vdupq_n_s32(value));
+    } else {
+        return vceqq_u32(vld1q_u32(p), vdupq_n_u32(value));
+    }
+}
+
+template <typename T>
+const T* FindNeon(const T* first, const T* last, T value) noexcept {
+    for (; last - first >= 4; first += 4) {
+        if (vmaxvq_u32(EqualMaskNeon(first, value)) != 0) {
+            return FindScalar(first, first + 4, value);
+        }
+    }
+    return FindScalar(first, last, value);
+}
+
+template <typename T>
+size_t CountNeon(const T* first, const T* last, T value) noexcept {
+    size_t count = 0;
+    for (; last - first >= 4; first += 4) {
+        count += vaddvq_u32(vshrq_n_u32(EqualMaskNeon(first, value), 31));
+    }
+    return count + CountScalar(first, last, value);
+}
+
+template <typename T>
+void MinMaxNeon(const T* first, const T* last, T& min, T& max) noexcept {
+    if (last - first < 4) {
+        MinMaxScalar(first, last, min, max);
+        return;
+    }
+    T vector_min;
+    T vector_max;
+    if constexpr (std::is_same_v<T, float>) {
+        float32x4_t vmin = vdupq_n_f32(min);
+        float32x4_t vmax = vdupq_n_f32(max);
+        for (; last - first >= 4; first += 4) {
+            const float32x4_t x = vld1q_f32(first);
+            vmin = vminq_f32(x, vmin);
+            vmax = vmaxq_f32(x, vmax);
+        }
+        vector_min = vminvq_f32(vmin);
+        vector_max = vmaxvq_f32(vmax);
+    } else if constexpr (std::is_signed_v<T>) {
+        int32x4_t vmin = vdupq_n_s32(min);
+        int32x4_t vmax = vdupq_n_s32(max);
+        for (; last - first >= 4; first += 4) {
+            const int32x4_t x = vld1q_s32(first);
+            vmin = vminq_s32(x, vmin);
+            vmax = vmaxq_s32(x, vmax);
+        }
+        vector_min = vminvq_s32(vmin);
+        vector_max = vmaxvq_s32(vmax);
+    } else {
+        uint32x4_t vmin = vdupq_n_u32(min);
+        uint32x4_t vmax = vdupq_n_u32(max);
+        for (; last - first >= 4; first += 4) {
+            const uint32x4_t x = vld1q_u32(first);
+            vmin = vminq_u32(x, vmin);
+            vmax = vmaxq_u32(x, vmax);
+        }
+        vector_min = vminvq_u32(vmin);
+        vector_max = vmaxvq_u32(vmax);
+    }
+    MinMaxScalar(&vector_min, &vector_min + 1, min, max);
+    MinMaxScalar(&vector_max, &vector_max + 1, min, max);
+    MinMaxScalar(first, last, min, max);
+}
+
+template <typename T>
+SumType<T> SumNeon(const T* first, const T* last) noexcept {
+    SumType<T> sum = 0;
+    if constexpr (std::is_same_v<T, float>) {
+        float32x4_t acc0 = vdupq_n_f32(0);
+        float32x4_t acc1 = vdupq_n_f32(0);
+        for (; last - first >= 8; first += 8) {
+            acc0 = vaddq_f32(acc0, vld1q_f32(first));
+            acc1 = vaddq_f32(acc1, vld1q_f32(first + 4));
+        }
+        sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    } else if constexpr (std::is_signed_v<T>) {
+        int64x2_t acc = vdupq_n_s64(0);
+        for (; last - first >= 4; first += 4) {
+            acc = vpadalq_s32(acc, vld1q_s32(first));
+        }
+        sum = vaddvq_s64(acc);
+    } else {
+        uint64x2_t acc = vdupq_n_u64(0);
+        for (; last - first >= 4; first += 4) {
+            acc = vpadalq_u32(acc, vld1q_u32(first));
+        }
+        sum = vaddvq_u64(acc);
+    }
+    return sum + SumScalar(first, last);
+}
+
+#endif
+
+// Ядра с явно заданным набором инструкций. Неподдерживаемый этой сборкой набор заменяется скалярным
+// кодом, а поддерживает ли его процессор, проверяет вызывающий
+
+template <typename T>
+const T* Find(const T* first, const T* last, T value, SimdLevel level) noexcept {
+    if constexpr (HAS_SIMD_KERNELS<T>) {
+#if defined(VECTOR_SIMD_X86)
+        if (level == SimdLevel::AVX512) return FindAvx512(first, last, value);
+        if (level == SimdLevel::AVX2) return FindAvx2(first, last, value);
+#elif defined(VECTOR_SIMD_NEON)
+        if (level == SimdLevel::NEON) return FindNeon(first, last, value);
+#endif
+    }
+    (void)level;
+    return FindScalar(first, last, value);
+}
+
+template <typename T>
+size_t Count(const T* first, const T* last, T value, SimdLevel level) noexcept {
+    if constexpr (HAS_SIMD_KERNELS<T>) {
+#if defined(VECTOR_SIMD_X86)
+        if (level == SimdLevel::AVX512) return CountAvx512(first, last, value);
+        if (level == SimdLevel::AVX2) return CountAvx2(first, last, value);
+#elif defined(VECTOR_SIMD_NEON)
+        if (level == SimdLevel::NEON) return CountNeon(first, last, value);
+#endif
+    }
+    (void)level;
+    return CountScalar(first, last, value);
+}
+
+template <typename T>
+std::pair<T, T> MinMax(const T* first, const T* last, SimdLevel level) noexcept {
+    assert(first != last);
+    T min = *first;
+    T max = *first;
+    if constexpr (HAS_SIMD_KERNELS<T>) {
+#if defined(VECTOR_SIMD_X86)
+        if (level == SimdLevel::AVX512) {
+            MinMaxAvx512(first + 1, last, min, max);
+            return {min, max};
+        }
+        if (level == SimdLevel::AVX2) {
+            MinMaxAvx2(first + 1, last, min, max);
+            return {min, max};
+        }
+#elif defined(VECTOR_SIMD_NEON)
+        if (level == SimdLevel::NEON) {
+            MinMaxNeon(first + 1, last, min, max);
+            return {min, max};
+        }
+#endif
+    }
+    (void)level;
+    MinMaxScalar(first + 1, last, min, max);
+    return {min, max};
+}
+
+template <typename T>
+SumType<T> Sum(const T* first, const T* last, SimdLevel level) noexcept {
+    if constexpr (HAS_SIMD_KERNELS<T>) {
+#if defined(VECTOR_SIMD_X86)
+        if (level == SimdLevel::AVX512) return SumAvx512(first, last);
+        if (level == SimdLevel::AVX2) return SumAvx2(first, last);
+#elif defined(VECTOR_SIMD_NEON)
+        if (level == SimdLevel::NEON) return SumNeon(first, last);
+#endif
+    }
+    (void)level;
+    return SumScalar(first, last);
+}
+
+}  // namespace detail
+
+// Алгоритмы над непрерывными массивами арифметических элементов. Для int32_t, uint32_t и float они
+// выполняются векторными инструкциями лучшего набора, который поддерживает процессор, остальные типы
+// обрабатываются скалярным циклом. Сравнения для float следуют operator==: NaN не равен ничему,
+// а 0.0 равен -0.0. Если среди float есть NaN, результат MinMax не определен, а порядок сложения
+// в Sum отличается от последовательного, поэтому сумма float может отличаться в последних знаках
+
+template <typename T>
+const T* Find(const T* first, const T* last, detail::NonDeduced<T> value) noexcept {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Find requires arithmetic elements");
+    return detail::Find(first, last, value, DetectSimdLevel());
+}
+
+template <typename T>
+size_t Count(const T* first, const T* last, detail::NonDeduced<T> value) noexcept {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Count requires arithmetic elements");
+    return detail::Count(first, last, value, DetectSimdLevel());
+}
+
+template <typename T>
+bool Contains(const T* first, const T* last, detail::NonDeduced<T> value) noexcept {
+    return Find(first, last, value) != last;
+}
+
+// Наименьший и наибольший элементы непустого диапазона
+template <typename T>
+std::pair<T, T> MinMax(const T* first, const T* last) noexcept {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "MinMax requires arithmetic elements");
+    return detail::MinMax(first, last, DetectSimdLevel());
+}
+
+template <typename T>
+SumType<T> Sum(const T* first, const T* last) noexcept {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Sum requires arithmetic elements");
+    return detail::Sum(first, last, DetectSimdLevel());
+}
+
+// Те же алгоритмы для контейнеров с итераторами-указателями: Vector, SmallVector, MappedVector
+
+template <typename Container, typename = detail::EnableIfContiguous<Container>>
+auto Find(Container& container, typename Container::value_type value) noexcept {
+    return container.begin() + (Find(container.begin(), container.end(), value) - container.begin());
+}
+
+template <typename Container, typename = detail::EnableIfContiguous<Container>>
+size_t Count(const Container& container, typename Container::value_type value) noexcept {
+    return Count(container.begin(), container.end(), value);
+}
+
+template <typename Container, typename = detail::EnableIfContiguous<Container>>
+bool Contains(const Container& container, typename Container::value_type value) noexcept {
+    return Contains(container.begin(), container.end(), value);
+}
+
+template <typename Container, typename = detail::EnableIfContiguous<Container>>
+auto MinMax(const Container& container) noexcept {
+    return MinMax(container.begin(), container.end());
+}
+
+template <typename Container, typename = detail::EnableIfContiguous<Container>>
+auto Sum(const Container& container) noexcept {
+    return Sum(container.begin(), container.end());
+}
+
+#undef VECTOR_TARGET_AVX2
+#undef VECTOR_TARGET_AVX512
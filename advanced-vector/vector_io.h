@@ -0,0 +1,472 @@
+
+#pragma once
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "vector.h"
+
+// Двоичный формат Vector: заголовок, затем элементы. Тривиально копируемые элементы записываются
+// одним блоком байтов и читаются прямо в неинициализированную память вектора. Остальные типы
+// записываются записями [длина][байты] через VectorSerializer<T> и обрабатываются буфером
+// ограниченного размера, поэтому пиковая память не зависит от размера вектора.
+// Ошибки ввода-вывода сообщаются std::system_error, повреждённые данные - std::runtime_error
+
+struct VectorIoHeader {
+    static constexpr uint64_t MAGIC = 0x4f49434556564441;  // "ADVVECIO"
+
+    uint64_t magic = MAGIC;
+    // sizeof(T) для побайтового формата, 0 для формата записей
+    uint64_t element_size = 0;
+    uint64_t size = 0;
+    // Байт данных после заголовка: читатель потока не заходит за границу вектора
+    uint64_t bytes = 0;
+};
+
+// Буфер, которым кодируются и читаются записи нетривиальных типов
+inline constexpr size_t VECTOR_IO_CHUNK_BYTES = size_t{1} << 20;
+
+// Кодирование элемента нетривиального типа в запись. Специализация должна предоставлять
+//   static size_t Size(const T& value);           // длина записи в байтах
+//   static void Write(const T& value, char* out); // записывает ровно Size(value) байт
+//   static T Read(const char* in, size_t size);   // восстанавливает элемент из записи
+template <typename T, typename = void>
+struct VectorSerializer;
+
+template <typename Char, typename Traits, typename Alloc>
+struct VectorSerializer<std::basic_string<Char, Traits, Alloc>> {
+    using String = std::basic_string<Char, Traits, Alloc>;
+
+    static size_t Size(const String& value) noexcept {
+        return value.size() * sizeof(Char);
+    }
+
+    static void Write(const String& value, char* out) noexcept {
+        std::memcpy(out, value.data(), value.size() * sizeof(Char));
+    }
+
+    static String Read(const char* in, size_t size) {
+        if (size % sizeof(Char) != 0) {
+            throw std::runtime_error("Corrupted string record");
+        }
+        String value(size / sizeof(Char), Char());
+        std::memcpy(value.data(), in, size);
+        return value;
+    }
+};
+
+namespace detail {
+
+[[noreturn]] inline void ThrowIoError(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Записывает iov целиком, продолжая после частичных записей и прерываний сигналами
+inline void WriteAll(int fd, iovec* iov, int count) {
+    while (count > 0) {
+        const ssize_t written = writev(fd, iov, std::min(count, IOV_MAX));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            ThrowIoError("writev");
+        }
+        size_t left = static_cast<size_t>(written);
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov, --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+}
+
+inline void WriteAll(int fd, const char* data, size_t size) {
+    iovec iov{const_cast<char*>(data), size};
+    WriteAll(fd, &iov, 1);
+}
+
+inline void ReadAll(int fd, char* out, size_t size) {
+    while (size > 0) {
+        const ssize_t n = read(fd, out, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ThrowIoError("read");
+        }
+        if (n == 0) {
+            throw std::runtime_error("Unexpected end of vector data");
+        }
+        out += n, size -= static_cast<size_t>(n);
+    }
+}
+
+// Приемники и источники байтов для формата записей. Reserve/Take дают непрерывный участок
+// нужной длины, поэтому VectorSerializer работает с обычными указателями
+
+class FdSink {
+public:
+    FdSink(int fd, size_t buffer_size)
+        : fd_(fd)
+        , buffer_(buffer_size, DEFAULT_INIT) {}
+
+    char* Reserve(size_t n) {
+        if (used_ + n > buffer_.Size()) {
+            Flush();
+            if (n > buffer_.Size()) {
+                buffer_.ResizeDefaultInit(n);
+            }
+        }
+        return buffer_.begin() + used_;
+    }
+
+    void Commit(size_t n) noexcept {
+        used_ += n;
+    }
+
+    void Flush() {
+        WriteAll(fd_, buffer_.begin(), used_);
+        used_ = 0;
+    }
+
+private:
+    int fd_;
+    Vector<char> buffer_;
+    size_t used_ = 0;
+};
+
+class MemorySink {
+public:
+    MemorySink(char* out, size_t size) noexcept
+        : out_(out)
+        , left_(size) {}
+
+    char* Reserve(size_t n) {
+        if (n > left_) {
+            throw std::length_error("Buffer is too small for serialized vector");
+        }
+        return out_;
+    }
+
+    void Commit(size_t n) noexcept {
+        out_ += n, left_ -= n;
+    }
+
+    void Flush() noexcept {}
+
+private:
+    char* out_;
+    size_t left_;
+};
+
+class FdSource {
+public:
+    FdSource(int fd, size_t limit, size_t buffer_size)
+        : fd_(fd)
+        , limit_(limit)
+        , available_(RemainingFileBytes(fd))
+        , buffer_(buffer_size, DEFAULT_INIT) {}
+
+    // Сколько байтов заведомо есть во входе: остаток обычного файла, для канала или сокета 0
+    size_t Available() const noexcept {
+        return available_;
+    }
+
+    const char* Take(size_t n) {
+        if (end_ - begin_ < n) {
+            Fill(n);
+        }
+        const char* data = buffer_.begin() + begin_;
+        begin_ += n;
+        return data;
+    }
+
+    // Читает ровно n байтов прямо в out
+    void Read(char* out, size_t n) {
+        const size_t buffered = std::min(n, end_ - begin_);
+        if (n - buffered > limit_) {
+            throw std::runtime_error("Unexpected end of vector data");
+        }
+        if (buffered != 0) {
+            std::memcpy(out, buffer_.begin() + begin_, buffered);
+        }
+        begin_ += buffered;
+        ReadAll(fd_, out + buffered, n - buffered);
+        limit_ -= n - buffered;
+    }
+
+    // Читает все, что осталось до границы limit, прямо в out
+    void ReadRest(char* out, size_t n) {
+        if (n != limit_ + (end_ - begin_)) {
+            throw std::runtime_error("Corrupted vector data");
+        }
+        Read(out, n);
+    }
+
+    // Проверяет, что все данные вектора прочитаны
+    void Finish() const {
+        if (limit_ != 0 || begin_ != end_) {
+            throw std::runtime_error("Corrupted vector data");
+        }
+    }
+
+private:
+    int fd_;
+    // Сколько байтов вектора еще не прочитано из fd
+    size_t limit_;
+    size_t available_;
+    Vector<char> buffer_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+
+    void Fill(size_t n) {
+        const size_t buffered = end_ - begin_;
+        if (n - buffered > limit_) {
+            throw std::runtime_error("Unexpected end of vector data");
+        }
+        std::memmove(buffer_.begin(), buffer_.begin() + begin_, buffered);
+        begin_ = 0, end_ = buffered;
+        // Дочитывает сразу целый буфер, но не дальше конца вектора. Длина записи ничем не
+        // подтверждена, поэтому буфер растет вместе с пришедшими данными, не больше чем вдвое за раз
+        while (end_ < n) {
+            if (end_ == buffer_.Size()) {
+                buffer_.ResizeDefaultInit(std::min(n, std::max<size_t>(buffer_.Size() * 2, 1)));
+            }
+            const ssize_t got = read(fd_, buffer_.begin() + end_, std::min(buffer_.Size() - end_, limit_));
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                ThrowIoError("read");
+            }
+            if (got == 0) {
+                throw std::runtime_error("Unexpected end of vector data");
+            }
+            end_ += static_cast<size_t>(got), limit_ -= static_cast<size_t>(got);
+        }
+    }
+
+    static size_t RemainingFileBytes(int fd) noexcept {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            return 0;
+        }
+        const off_t pos = lseek(fd, 0, SEEK_CUR);
+        return pos >= 0 && pos <= st.st_size ? static_cast<size_t>(st.st_size - pos) : 0;
+    }
+};
+
+class MemorySource {
+public:
+    MemorySource(const char* data, size_t size) noexcept
+        : data_(data)
+        , left_(size) {}
+
+    const char* Take(size_t n) {
+        if (n > left_) {
+            throw std::runtime_error("Unexpected end of vector data");
+        }
+        const char* data = data_;
+        data_ += n, left_ -= n;
+        return data;
+    }
+
+    size_t Available() const noexcept {
+        return left_;
+    }
+
+    void Read(char* out, size_t n) {
+        const char* data = Take(n);
+        if (n != 0) {
+            std::memcpy(out, data, n);
+        }
+    }
+
+    void ReadRest(char* out, size_t n) {
+        if (n != left_) {
+            throw std::runtime_error("Corrupted vector data");
+        }
+        Read(out, n);
+    }
+
+    void Finish() const {
+        if (left_ != 0) {
+            throw std::runtime_error("Corrupted vector data");
+        }
+    }
+
+private:
+    const char* data_;
+    size_t left_;
+};
+
+template <typename T>
+constexpr bool IsBitwiseSerializable() noexcept {
+    return std::is_trivially_copyable_v<T>;
+}
+
+template <typename T, typename A, typename G, typename S>
+uint64_t SerializedDataBytes(const Vector<T, A, G, S>& vector) {
+    if constexpr (IsBitwiseSerializable<T>()) {
+        return vector.Size() * sizeof(T);
+    } else {
+        uint64_t bytes = 0;
+        for (const T& value : vector) {
+            bytes += sizeof(uint64_t) + VectorSerializer<T>::Size(value);
+        }
+        return bytes;
+    }
+}
+
+template <typename T, typename A, typename G, typename S>
+VectorIoHeader MakeHeader(const Vector<T, A, G, S>& vector) {
+    VectorIoHeader header;
+    header.element_size = IsBitwiseSerializable<T>() ? sizeof(T) : 0;
+    header.size = vector.Size();
+    header.bytes = SerializedDataBytes(vector);
+    return header;
+}
+
+template <typename T, typename Sink>
+void WriteRecords(const T* first, size_t count, Sink& sink) {
+    for (const T* value = first; value != first + count; ++value) {
+        const uint64_t size = VectorSerializer<T>::Size(*value);
+        char* out = sink.Reserve(sizeof(size) + size);
+        std::memcpy(out, &size, sizeof(size));
+        VectorSerializer<T>::Write(*value, out + sizeof(size));
+        sink.Commit(sizeof(size) + size);
+    }
+    sink.Flush();
+}
+
+template <typename VectorT, typename Source>
+VectorT ReadVector(const VectorIoHeader& header, Source& source) {
+    using T = typename VectorT::value_type;
+    if (header.magic != VectorIoHeader::MAGIC || header.element_size != (IsBitwiseSerializable<T>() ? sizeof(T) : 0)) {
+        throw std::runtime_error("Serialized vector has a different element type");
+    }
+    VectorT result;
+    if constexpr (IsBitwiseSerializable<T>()) {
+        if (header.bytes % sizeof(T) != 0 || header.bytes / sizeof(T) != header.size) {
+            throw std::runtime_error("Corrupted vector data");
+        }
+        if (header.bytes <= source.Available()) {
+            result.Reserve(header.size);
+            result.ResizeAndOverwrite(header.size, [&](T* data, size_t count) {
+                source.ReadRest(reinterpret_cast<char*>(data), count * sizeof(T));
+                return count;
+            });
+            return result;
+        }
+        // Длина входа неизвестна, и размер из заголовка ничем не подтвержден: память растет вместе
+        // с прочитанными данными и не больше чем вдвое превышает то, что действительно пришло
+        const size_t chunk = std::max<size_t>(VECTOR_IO_CHUNK_BYTES / sizeof(T), 1);
+        size_t done = 0;
+        while (done < header.size) {
+            const size_t count = std::min<uint64_t>(header.size - done, std::max(done, chunk));
+            result.ResizeAndOverwrite(done + count, [&](T* data, size_t /*capacity*/) {
+                source.Read(reinterpret_cast<char*>(data + done), count * sizeof(T));
+                return done + count;
+            });
+            done += count;
+        }
+        source.Finish();
+    } else {
+        // Каждая запись занимает хотя бы длину. Заранее резервируется место только под записи,
+        // которые помещаются в заведомо доступные байты, остальное растет по мере чтения
+        if (header.size > header.bytes / sizeof(uint64_t)) {
+            throw std::runtime_error("Corrupted vector data");
+        }
+        result.Reserve(std::min<uint64_t>(header.size, source.Available() / sizeof(uint64_t)));
+        for (uint64_t i = 0; i < header.size; ++i) {
+            uint64_t size;
+            std::memcpy(&size, source.Take(sizeof(size)), sizeof(size));
+            result.EmplaceBack(VectorSerializer<T>::Read(source.Take(size), size));
+        }
+        source.Finish();
+    }
+    return result;
+}
+
+}  // namespace detail
+
+// Размер сериализованного вектора в байтах, включая заголовок
+template <typename T, typename A, typename G, typename S>
+size_t SerializedSize(const Vector<T, A, G, S>& vector) {
+    return sizeof(VectorIoHeader) + detail::SerializedDataBytes(vector);
+}
+
+// Записывает вектор в fd. Тривиально копируемые элементы уходят вместе с заголовком одним writev,
+// остальные - буфером по chunk_bytes
+template <typename T, typename A, typename G, typename S>
+void Serialize(int fd, const Vector<T, A, G, S>& vector, size_t chunk_bytes = VECTOR_IO_CHUNK_BYTES) {
+    VectorIoHeader header = detail::MakeHeader(vector);
+    if constexpr (detail::IsBitwiseSerializable<T>()) {
+        iovec iov[2] = {{&header, sizeof(header)}, {const_cast<T*>(vector.Data()), vector.Size() * sizeof(T)}};
+        detail::WriteAll(fd, iov, 2);
+    } else {
+        detail::WriteAll(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+        detail::FdSink sink(fd, chunk_bytes);
+        detail::WriteRecords(vector.Data(), vector.Size(), sink);
+    }
+}
+
+// Заполняет iov для собственного writev или sendmsg. header должен жить, пока iov используется
+template <typename T, typename A, typename G, typename S>
+void SerializeIovec(const Vector<T, A, G, S>& vector, VectorIoHeader& header, iovec (&iov)[2]) {
+    static_assert(detail::IsBitwiseSerializable<T>(), "Only trivially copyable elements can be referenced by iovec");
+    header = detail::MakeHeader(vector);
+    iov[0] = {&header, sizeof(header)};
+    iov[1] = {const_cast<T*>(vector.Data()), vector.Size() * sizeof(T)};
+}
+
+// Записывает вектор в буфер [out, out + size) и возвращает число записанных байтов.
+// Если буфер мал, бросает std::length_error
+template <typename T, typename A, typename G, typename S>
+size_t Serialize(const Vector<T, A, G, S>& vector, char* out, size_t size) {
+    const VectorIoHeader header = detail::MakeHeader(vector);
+    const size_t total = sizeof(header) + header.bytes;
+    if (total > size) {
+        throw std::length_error("Buffer is too small for serialized vector");
+    }
+    std::memcpy(out, &header, sizeof(header));
+    if constexpr (detail::IsBitwiseSerializable<T>()) {
+        if (header.bytes != 0) {
+            std::memcpy(out + sizeof(header), vector.Data(), header.bytes);
+        }
+    } else {
+        detail::MemorySink sink(out + sizeof(header), header.bytes);
+        detail::WriteRecords(vector.Data(), vector.Size(), sink);
+    }
+    return total;
+}
+
+// Читает из fd ровно один вектор, записанный Serialize. Память под элементы выделяется один раз,
+// тривиально копируемые элементы читаются прямо в нее
+template <typename VectorT>
+VectorT Deserialize(int fd, size_t chunk_bytes = VECTOR_IO_CHUNK_BYTES) {
+    VectorIoHeader header;
+    detail::ReadAll(fd, reinterpret_cast<char*>(&header), sizeof(header));
+    detail::FdSource source(fd, header.bytes, detail::IsBitwiseSerializable<typename VectorT::value_type>() ? 0 : chunk_bytes);
+    return detail::ReadVector<VectorT>(header, source);
+}
+
+template <typename VectorT>
+VectorT Deserialize(const char* data, size_t size) {
+    VectorIoHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Unexpected end of vector data");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (size - sizeof(header) < header.bytes) {
+        throw std::runtime_error("Unexpected end of vector data");
+    }
+    detail::MemorySource source(data + sizeof(header), header.bytes);
+    return detail::ReadVector<VectorT>(header, source);
+}
@@ -0,0 +1,202 @@
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include "vector.h"
+
+// Кэш освобожденных буферов одного потока. Блоки до MAX_BLOCK_SIZE байт округляются до степени
+// двойки и при освобождении попадают в список своего класса размера, откуда их забирает следующее
+// выделение того же класса без обращения к malloc. В каждом списке хранится не больше MaxBlocks()
+// блоков, лишние и более крупные блоки сразу возвращаются через operator delete. Пул не
+// синхронизирован: блок, выделенный в одном потоке, при освобождении в другом попадает в пул
+// освобождающего потока
+class VectorPool {
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 64;
+    static constexpr size_t MAX_BLOCK_SIZE = size_t{1} << 20;
+    static constexpr size_t DEFAULT_MAX_BLOCKS = 32;
+
+    VectorPool(const VectorPool&) = delete;
+    VectorPool& operator=(const VectorPool&) = delete;
+
+    // Уничтожение пула отмечается во флаге с тривиальным деструктором, который доступен до конца
+    // жизни потока: буферы thread_local и static векторов могут освобождаться уже после пула
+    ~VectorPool() {
+        LocalDestroyed() = true;
+        Trim();
+    }
+
+    // Пул текущего потока или nullptr, если поток завершается и его пул уже уничтожен
+    static VectorPool* Local() noexcept {
+        if (LocalDestroyed()) {
+            return nullptr;
+        }
+        thread_local VectorPool pool;
+        return &pool;
+    }
+
+    // Размер блока, который выделяется под bytes байтов. Блок любого размера до MAX_BLOCK_SIZE
+    // занимает целый класс, поэтому его может принять пул любого потока
+    static size_t BlockBytes(size_t bytes) noexcept {
+        return bytes > MAX_BLOCK_SIZE ? bytes : BlockSize(ClassOf(bytes));
+    }
+
+    void* Allocate(size_t bytes) {
+        if (bytes > MAX_BLOCK_SIZE) {
+            return ::operator new(bytes);
+        }
+        SizeClass& size_class = classes_[ClassOf(bytes)];
+        if (size_class.head == nullptr) {
+            return ::operator new(BlockBytes(bytes));
+        }
+        FreeBlock* block = size_class.head;
+        size_class.head = block->next;
+        --size_class.count;
+        return block;
+    }
+
+    void Deallocate(void* p, size_t bytes) noexcept {
+        if (bytes > MAX_BLOCK_SIZE) {
+            ::operator delete(p);
+            return;
+        }
+        SizeClass& size_class = classes_[ClassOf(bytes)];
+        if (size_class.count == max_blocks_) {
+            ::operator delete(p);
+            return;
+        }
+        size_class.head = new (p) FreeBlock{size_class.head};
+        ++size_class.count;
+    }
+
+    // Освобождает закэшированные блоки, оставляя в каждом списке не больше keep
+    void Trim(size_t keep = 0) noexcept {
+        for (SizeClass& size_class : classes_) {
+            while (size_class.count > keep) {
+                FreeBlock* block = size_class.head;
+                size_class.head = block->next;
+                --size_class.count;
+                ::operator delete(block);
+            }
+        }
+    }
+
+    // Новое ограничение сразу применяется к уже закэшированным блокам
+    void SetMaxBlocks(size_t max_blocks) noexcept {
+        max_blocks_ = max_blocks;
+        Trim(max_blocks);
+    }
+
+    size_t MaxBlocks() const noexcept {
+        return max_blocks_;
+    }
+
+    size_t CachedBlocks() const noexcept {
+        size_t count = 0;
+        for (const SizeClass& size_class : classes_) {
+            count += size_class.count;
+        }
+        return count;
+    }
+
+    size_t CachedBytes() const noexcept {
+        size_t bytes = 0;
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            bytes += classes_[i].count * BlockSize(i);
+        }
+        return bytes;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SizeClass {
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+    };
+
+    VectorPool() = default;
+
+    static constexpr size_t CLASS_COUNT = [] {
+        size_t count = 1;
+        for (size_t size = MIN_BLOCK_SIZE; size < MAX_BLOCK_SIZE; size *= 2) {
+            ++count;
+        }
+        return count;
+    }();
+
+    std::array<SizeClass, CLASS_COUNT> classes_;
+    size_t max_blocks_ = DEFAULT_MAX_BLOCKS;
+
+    static bool& LocalDestroyed() noexcept {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    static size_t ClassOf(size_t bytes) noexcept {
+        size_t index = 0;
+        while (BlockSize(index) < bytes) {
+            ++index;
+        }
+        return index;
+    }
+
+    static constexpr size_t BlockSize(size_t index) noexcept {
+        return MIN_BLOCK_SIZE << index;
+    }
+};
+
+// Аллокатор, который берет буферы из пула текущего потока и возвращает их туда же. Блок
+// освобождается по размеру, поэтому его может принять пул любого потока, и все копии аллокатора равны
+template <typename T>
+struct PoolAllocator {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "operator new does not provide required alignment");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& /*other*/) noexcept {}
+
+    // Без пула блок все равно выделяется размером целого класса: его может освободить поток, у
+    // которого пул еще жив
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        VectorPool* pool = VectorPool::Local();
+        void* p = pool != nullptr ? pool->Allocate(n * sizeof(T)) : ::operator new(VectorPool::BlockBytes(n * sizeof(T)));
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (VectorPool* pool = VectorPool::Local()) {
+            pool->Deallocate(p, n * sizeof(T));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& /*other*/) const noexcept {
+        return false;
+    }
+};
+
+// Vector, который переиспользует буферы уничтоженных векторов своего потока
+template <typename T, typename GrowthPolicy = DoublingGrowth>
+using PooledVector = Vector<T, PoolAllocator<T>, GrowthPolicy>;
@@ -0,0 +1,164 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+
+#include "vector.h"
+
+class VectorStatsRegistry;
+
+// Счетчики одной группы векторов. Обновляются без блокировок, поэтому векторы группы
+// могут жить в разных потоках. Счетчики инициализируются на этапе компиляции и имеют
+// тривиальный деструктор, поэтому доступны и из деструкторов статических объектов
+struct VectorStatsCounters {
+    constexpr explicit VectorStatsCounters(const char* name) noexcept
+        : name(name) {}
+
+    void Reset() noexcept {
+        for (auto* counter : {&allocations, &reallocations, &in_place_reallocations, &bytes_allocated,
+                              &elements_relocated_bitwise, &elements_moved, &elements_copied,
+                              &peak_capacity_bytes, &wasted_capacity_bytes, &destroyed}) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+
+    const char* name;
+    // Все выделения буферов, включая первое
+    std::atomic<uint64_t> allocations{0};
+    // Выделения, при которых у вектора уже был буфер
+    std::atomic<uint64_t> reallocations{0};
+    std::atomic<uint64_t> in_place_reallocations{0};
+    std::atomic<uint64_t> bytes_allocated{0};
+    std::atomic<uint64_t> elements_relocated_bitwise{0};
+    std::atomic<uint64_t> elements_moved{0};
+    // Элементы, скопированные при реаллокации, потому что их перемещение может бросить исключение
+    std::atomic<uint64_t> elements_copied{0};
+    std::atomic<uint64_t> peak_capacity_bytes{0};
+    // Сумма неиспользованной емкости векторов на момент их разрушения
+    std::atomic<uint64_t> wasted_capacity_bytes{0};
+    std::atomic<uint64_t> destroyed{0};
+
+private:
+    friend class VectorStatsRegistry;
+
+    std::atomic<bool> registered_{false};
+    const VectorStatsCounters* next_ = nullptr;
+};
+
+// Реестр всех групп счетчиков, которые были задействованы в программе. Группы связаны в
+// односвязный список через сами счетчики, поэтому регистрация не выделяет память и не блокирует
+class VectorStatsRegistry {
+public:
+    static VectorStatsRegistry& Instance() noexcept {
+        static VectorStatsRegistry registry;
+        return registry;
+    }
+
+    // Повторная регистрация той же группы ничего не делает
+    void Register(VectorStatsCounters& counters) noexcept {
+        if (counters.registered_.load(std::memory_order_relaxed)
+            || counters.registered_.exchange(true, std::memory_order_relaxed)) {
+            return;
+        }
+        counters.next_ = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(counters.next_, &counters, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    // Группы выводятся от последней зарегистрированной к первой
+    void Dump(std::ostream& out) const {
+        for (const VectorStatsCounters* c = head_.load(std::memory_order_acquire); c != nullptr; c = c->next_) {
+            out << c->name
+                << ": allocations=" << c->allocations.load(std::memory_order_relaxed)
+                << " reallocations=" << c->reallocations.load(std::memory_order_relaxed)
+                << " in_place_reallocations=" << c->in_place_reallocations.load(std::memory_order_relaxed)
+                << " bytes_allocated=" << c->bytes_allocated.load(std::memory_order_relaxed)
+                << " relocated_bitwise=" << c->elements_relocated_bitwise.load(std::memory_order_relaxed)
+                << " moved=" << c->elements_moved.load(std::memory_order_relaxed)
+                << " copied=" << c->elements_copied.load(std::memory_order_relaxed)
+                << " peak_capacity_bytes=" << c->peak_capacity_bytes.load(std::memory_order_relaxed)
+                << " wasted_capacity_bytes=" << c->wasted_capacity_bytes.load(std::memory_order_relaxed)
+                << " destroyed=" << c->destroyed.load(std::memory_order_relaxed) << '\n';
+        }
+    }
+
+private:
+    constexpr VectorStatsRegistry() noexcept = default;
+
+    std::atomic<const VectorStatsCounters*> head_{nullptr};
+};
+
+static_assert(std::is_trivially_destructible_v<VectorStatsCounters>);
+static_assert(std::is_trivially_destructible_v<VectorStatsRegistry>);
+
+struct GlobalVectorStatsTag {
+    static constexpr const char* NAME = "global";
+};
+
+// Политика статистики для Vector. Счетчики общие для всех векторов с одинаковым Tag, поэтому
+// отдельный Tag с полем NAME на каждое место использования дает статистику в разрезе мест вызова:
+//   struct RequestBuffers { static constexpr const char* NAME = "request buffers"; };
+//   Vector<char, std::allocator<char>, DoublingGrowth, VectorStats<RequestBuffers>> buffer;
+template <typename Tag = GlobalVectorStatsTag>
+struct VectorStats {
+    static VectorStatsCounters& Counters() noexcept {
+        VectorStatsRegistry::Instance().Register(counters_);
+        return counters_;
+    }
+
+    static void OnAllocate(size_t capacity, size_t old_capacity, size_t element_size) noexcept {
+        if (capacity == 0) return;
+        VectorStatsCounters& c = Counters();
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        if (old_capacity != 0) {
+            c.reallocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        c.bytes_allocated.fetch_add(capacity * element_size, std::memory_order_relaxed);
+        UpdatePeak(c, capacity * element_size);
+    }
+
+    static void OnReallocateInPlace(size_t capacity, size_t old_capacity, size_t element_size) noexcept {
+        VectorStatsCounters& c = Counters();
+        c.reallocations.fetch_add(1, std::memory_order_relaxed);
+        c.in_place_reallocations.fetch_add(1, std::memory_order_relaxed);
+        if (capacity > old_capacity) {
+            c.bytes_allocated.fetch_add((capacity - old_capacity) * element_size, std::memory_order_relaxed);
+        }
+        UpdatePeak(c, capacity * element_size);
+    }
+
+    static void OnRelocate(size_t count, RelocationKind kind) noexcept {
+        if (count == 0) return;
+        VectorStatsCounters& c = Counters();
+        switch (kind) {
+            case RelocationKind::BITWISE:
+                c.elements_relocated_bitwise.fetch_add(count, std::memory_order_relaxed);
+                break;
+            case RelocationKind::MOVE:
+                c.elements_moved.fetch_add(count, std::memory_order_relaxed);
+                break;
+            case RelocationKind::COPY:
+                c.elements_copied.fetch_add(count, std::memory_order_relaxed);
+                break;
+        }
+    }
+
+    static void OnDestroy(size_t capacity, size_t size, size_t element_size) noexcept {
+        VectorStatsCounters& c = Counters();
+        c.destroyed.fetch_add(1, std::memory_order_relaxed);
+        c.wasted_capacity_bytes.fetch_add((capacity - size) * element_size, std::memory_order_relaxed);
+    }
+
+private:
+    static inline VectorStatsCounters counters_{Tag::NAME};
+
+    static void UpdatePeak(VectorStatsCounters& c, uint64_t bytes) noexcept {
+        uint64_t peak = c.peak_capacity_bytes.load(std::memory_order_relaxed);
+        while (peak < bytes && !c.peak_capacity_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+        }
+    }
+};